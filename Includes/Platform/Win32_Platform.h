@@ -6,8 +6,10 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 
+#include <atomic>
 #include <cstdint>
 #include <iostream>
+#include <string>
 
 // WIN32 PLATFORM LAYER COMPILATION FLAGS
 
@@ -31,20 +33,57 @@
 // Folder where new versions of the client library can be retrieved and hotreloaded as the program is running.
 #define CLIENT_MODULE_SOURCE_PATH "Dependencies\\Synergy\\SynergyClientLib\\"
 
+// Time client library files must go without changing before a new version is considered complete by the hotreload watcher.
+#define HOTRELOAD_WATCHER_DEBOUNCE_MS (500)
+
 #endif // HOTRELOAD_SUPPORTED
 
 #define CLIENT_FRAMES_PER_SECOND (60)
 #define CLIENT_FRAME_TIME (1.f / CLIENT_FRAMES_PER_SECOND)
 
+// Maximum number of input records that can be waiting for the main thread at once. Must be a power of two.
+#define WIN32_INPUT_QUEUE_CAPACITY (4096)
+
+// Maximum number of asynchronous file requests the client can have pending at once.
+#define WIN32_FILE_IO_MAX_REQUESTS (256)
+
+// Threads reading files on behalf of the client, and the size of the chunks they read files in.
+#define WIN32_FILE_IO_WORKER_COUNT (2)
+#define WIN32_FILE_IO_CHUNK_SIZE (1024 * 1024)
+
+// Address space reserved for each thread's scratch arena, and the steps it gets committed in as it grows.
+#define WIN32_SCRATCH_ARENA_RESERVE_SIZE (64ull * 1024 * 1024)
+#define WIN32_SCRATCH_ARENA_COMMIT_STEP (64 * 1024)
+
 // --------------------------------------
 
 // CLIENT LOADING & API
 
 struct SynergyClientAPI;
+struct ClientSessionData;
 
 void Win32_LoadClientModule(SynergyClientAPI& APIStruct, std::string LibNameOverride = "");
 void Win32_UnloadClientModule(SynergyClientAPI& API);
 
+/*
+	Returns the layout version of the client's persistent memory, as exported by the loaded client library through the optional
+	"GetPersistentMemoryLayoutVersion" symbol. Returns 0 if no library is loaded or it doesn't export the symbol.
+*/
+uint32_t Win32_GetClientPersistentMemoryLayoutVersion();
+
+/*
+	Runs the loaded client library's optional "ResumeClient" symbol in place of StartClient, for a session whose persistent memory holds the
+	state of a previous run. Returns false, having run nothing, if no library is loaded or it doesn't export the symbol.
+*/
+bool Win32_ResumeClient(ClientSessionData& Session);
+
+/*
+	Returns for how many milliseconds the client can go without running another frame if no input comes in, as told by the loaded client library
+	through the optional "GetIdleWaitMilliseconds" symbol. Returns 0, meaning the next frame should run right away, if no library is loaded or it
+	doesn't export the symbol.
+*/
+uint32_t Win32_GetClientIdleWaitMilliseconds(ClientSessionData& Session);
+
 #if HOTRELOAD_SUPPORTED
 /*
 	Checks if a new Client library version is available for hotreload, and if there is, do it immediately.Returns whether hotreload was successful.
@@ -52,10 +91,146 @@ void Win32_UnloadClientModule(SynergyClientAPI& API);
 */
 bool Win32_TryHotreloadClientModule(SynergyClientAPI& API, bool bForce = false);
 
+/*
+	Starts a background thread watching CLIENT_MODULE_SOURCE_PATH for changes, which flags new client library versions once they are complete.
+	Avoids polling the file system every frame.
+*/
+void Win32_StartHotreloadWatcher();
+
+// Stops the hotreload watcher thread, waiting for it to exit.
+void Win32_StopHotreloadWatcher();
+
+/*
+	Hotreloads the client module if the watcher flagged a new library version as ready since the last call. Meant to be called on frame boundaries.
+	Performs no system call unless a new version was flagged. Returns whether a hotreload happened and was successful.
+*/
+bool Win32_HotreloadClientModuleIfReady(SynergyClientAPI& API);
+
+/*
+	Launches the hotreload compile script in the background, unless one is already running. Frames keep running with the current client module
+	in the meantime.
+*/
+void Win32_StartHotreloadCompile();
+
+/*
+	Checks on the background hotreload compile, if any. Once it is done, reports its duration and outcome and hotreloads the client module if it
+	succeeded and bHotreload is set. Meant to be called on frame boundaries.
+*/
+void Win32_UpdateHotreloadCompile(SynergyClientAPI& API, bool bHotreload = true);
+
 // Cleans up the current iteration of hot reloaded client module files from working directory.
 void Win32_CleanupHotreloadFiles();
 #endif
 
+// CLIENT HOST
+
+struct ClientFrameRequestData;
+struct PlatformRenderStats;
+struct Win32DrawCallBuffer;
+struct Win32ClientHostChannelHeader;
+
+// Size of each viewport's draw call buffer, in bytes.
+#define WIN32_DRAW_CALL_BUFFER_SIZE (64000)
+
+// Viewports a client running in a client host process can allocate, each getting a draw call buffer in shared memory.
+#define CLIENT_HOST_MAX_VIEWPORTS (16)
+
+// Action Input events a client host frame can receive. Any more get dropped.
+#define CLIENT_HOST_INPUT_EVENT_CAPACITY (1024)
+
+// Time the client host is given to respond to any command before it is considered hung and gets terminated.
+#define CLIENT_HOST_RESPONSE_TIMEOUT_MS (10000)
+
+/*
+	Link between the platform and a client host process running the client on its behalf (-isolate-client), made of shared memory holding
+	client memory and frame data (see Win32_ClientHost_INC.cpp for its layout) and of events handing control back and forth.
+	Used on both ends, Process being the client host for the platform and the platform for the client host.
+*/
+struct Win32ClientHost
+{
+	std::string Name = "";
+
+	// Arguments client host processes get launched with, after the client host option.
+	std::string LaunchArguments = "";
+
+	HANDLE Mapping = NULL;
+	Win32ClientHostChannelHeader* Header = nullptr;
+
+	HANDLE CommandEvent = NULL;
+	HANDLE DoneEvent = NULL;
+	HANDLE RequestEvent = NULL;
+	HANDLE ReplyEvent = NULL;
+
+	HANDLE Process = NULL;
+};
+
+/*
+	Creates shared memory holding PersistentMemorySize bytes of client persistent memory and launches a client host process linked to it, which
+	loads the client library and gives its frames FrameMemorySize bytes of frame memory. Shared memory stays the same across client host restarts,
+	but persistent memory gets zeroed by each of them (see Win32_RestartClientHost()). LaunchArguments get passed on to the client host process.
+	Returns whether the client host could be launched.
+*/
+bool Win32_StartClientHost(Win32ClientHost& Host, size_t PersistentMemorySize, size_t FrameMemorySize, const std::string& LaunchArguments = "");
+
+/*
+	Launches a new client host process after the previous one crashed or hung, zeroing out client persistent memory. The client must be started
+	again. Returns whether the process could be launched.
+*/
+bool Win32_RestartClientHost(Win32ClientHost& Host);
+
+// Returns the client's persistent memory, found in shared memory. nullptr if the client host isn't started.
+uint8_t* Win32_GetClientHostPersistentMemory(const Win32ClientHost& Host);
+
+/*
+	Returns the draw call buffer of the passed viewport, found in shared memory and holding WIN32_DRAW_CALL_BUFFER_SIZE bytes.
+	nullptr if the client host isn't started or the viewport is past CLIENT_HOST_MAX_VIEWPORTS.
+*/
+uint8_t* Win32_GetClientHostDrawCallBuffer(const Win32ClientHost& Host, uint32_t ViewportIndex);
+
+/*
+	Have the client host start the client, or run a frame with the passed frame data, and wait for it to be done. Viewport allocation and destruction
+	requests made by the client in the meantime are carried out with the platform functions of Session.
+	Return false if the client host crashed or stopped responding, in which case it must be restarted.
+*/
+bool Win32_RunClientHostStart(Win32ClientHost& Host, ClientSessionData& Session);
+bool Win32_RunClientHostFrame(Win32ClientHost& Host, ClientSessionData& Session, const ClientFrameRequestData& FrameData);
+
+// Returns for how many milliseconds the client can go without running another frame, as told by the client library after its last frame.
+uint32_t Win32_GetClientHostIdleWaitMilliseconds(const Win32ClientHost& Host);
+
+// Sets the size draw calls made for the passed viewport get culled against during the next frames.
+void Win32_SetClientHostCullSize(Win32ClientHost& Host, uint32_t ViewportIndex, uint16_t Width, uint16_t Height);
+
+/*
+	Copies what the client host kept track of while the client wrote into the passed viewport's draw call buffer over the last frame (rejected and
+	culled draw calls, clip commands) into Buffer, the platform's side of it, so that it can be read.
+*/
+void Win32_SyncClientHostDrawCallBuffer(const Win32ClientHost& Host, uint32_t ViewportIndex, Win32DrawCallBuffer& Buffer);
+
+// Hands the rendering statistics of the passed viewport's last frame to the client host, for the client to query during its next frames.
+void Win32_SetClientHostRenderStats(Win32ClientHost& Host, uint32_t ViewportIndex, const PlatformRenderStats& Stats);
+
+/*
+	Client host process side. Returns the draw call buffer the client writes into for the passed viewport.
+	nullptr if there is no such viewport or this process isn't a client host.
+*/
+Win32DrawCallBuffer* Win32_GetHostedClientDrawCallBuffer(uint32_t ViewportIndex);
+
+/*
+	Client host process side. Fills OutStats with the last rendering statistics the platform handed over for the passed viewport.
+	Returns false if there is no such viewport or this process isn't a client host.
+*/
+bool Win32_GetClientHostRenderStats(uint32_t ViewportIndex, PlatformRenderStats& OutStats);
+
+// Has the client host shut the client down and exit, then frees the shared memory.
+void Win32_StopClientHost(Win32ClientHost& Host, ClientSessionData& Session);
+
+/*
+	Client host process side. Links up with the platform through the shared memory named Name and runs the client with the passed API on its
+	behalf until told to shut down or the platform exits. Returns the process exit code.
+*/
+int Win32_RunClientHost(const std::string& Name, SynergyClientAPI& API);
+
 // -----------------------------
 
 // DRAWING
@@ -75,11 +250,103 @@ union Win32PixelRGBA
 	uint32_t full;
 };
 
-typedef Win32PixelRGBA* Win32PixelBuffer;
+// Pixel surfaces get their allocated width and height rounded up to a multiple of this many pixels, so resizes only re-allocate when crossing size classes.
+#define WIN32_PIXEL_SURFACE_SIZE_CLASS (128)
+
+// Surface rows are padded to a multiple of this many pixels (64 bytes), so that every row starts on a cache line boundary.
+#define WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT (16)
+
+static_assert(WIN32_PIXEL_SURFACE_SIZE_CLASS % WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT == 0, "Pixel surface size classes must keep rows aligned.");
+
+// Maximum number of unused pixel surfaces kept around for reuse.
+#define WIN32_PIXEL_SURFACE_POOL_CAPACITY (8)
+
+/*
+	Pixels rasterized into, backed by a GDI Device-Independent Bitmap section so they can be blitted onto windows directly.
+	Only the top-left Width x Height pixels are visible. Rows are Stride pixels apart in memory, Stride being a multiple of
+	WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT.
+*/
+struct Win32PixelSurface
+{
+	Win32PixelRGBA* Pixels = nullptr;
+	uint16_t Width = 0;
+	uint16_t Height = 0;
+	uint32_t Stride = 0;
+
+	// Allocated height, in rows of Stride pixels.
+	uint32_t CapacityHeight = 0;
+
+	// Bitmap backing the pixels and a memory Device Context it is selected into, to be used as blit source.
+	HBITMAP Bitmap = NULL;
+	HDC BitmapDC = NULL;
+
+	// Whether the pixels live in a caller provided file mapping section (see Win32_CreatePixelSurfaceOnSection()). Such surfaces are never pooled.
+	bool bOnSection = false;
+};
+
+/*
+	Makes Surface hold at least Width x Height visible pixels. Its allocation is kept if it is large enough and isn't more than a size class
+	too large, otherwise it is swapped for a pooled or new one. Pixel content is undefined after a re-allocation.
+	The pool is shared between threads, but a given surface must only be used by one thread at a time. Returns whether the surface could be allocated.
+*/
+bool Win32_ResizePixelSurface(Win32PixelSurface& Surface, uint16_t Width, uint16_t Height);
+
+/*
+	Re-creates Surface with Width x Height visible pixels placed in the passed file mapping Section at SectionOffset, letting other processes see
+	them as they get rasterized. The section must hold Height rows of Width pixels rounded up to
+	WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT past SectionOffset.
+	Returns whether the surface could be created.
+*/
+bool Win32_CreatePixelSurfaceOnSection(Win32PixelSurface& Surface, uint16_t Width, uint16_t Height, HANDLE Section, DWORD SectionOffset);
+
+// Hands the allocation of Surface back to the pool and resets it. Surfaces placed in a section are freed instead.
+void Win32_ReleasePixelSurface(Win32PixelSurface& Surface);
+
+// Frees every surface held by the pool.
+void Win32_FreePixelSurfacePool();
+
+void Win32_ClearPixelSurface(Win32PixelRGBA PixelColor, Win32PixelSurface& Surface);
+
+// Maximum number of clip rectangles a viewport's clip stack can hold at once.
+#define WIN32_CLIP_STACK_CAPACITY (16)
+
+// Rectangle draw calls get clipped to, in pixels. Min coordinates are INCLUSIVE, max coordinates EXCLUSIVE.
+struct Win32ClipRect
+{
+	int32_t MinX = 0;
+	int32_t MinY = 0;
+	int32_t MaxX = 0;
+	int32_t MaxY = 0;
+};
 
-void Win32_ClearPixelBuffer(Win32PixelRGBA PixelColor, Win32PixelBuffer& PixelBuffer, uint16_t BufferWidth, uint16_t BufferHeight);
+// Returns the rectangle covering the whole surface.
+Win32ClipRect Win32_GetSurfaceClipRect(const Win32PixelSurface& Surface);
 
-void Win32_ProcessDrawCall(DrawCall& Call, Win32PixelBuffer& PixelBuffer, uint16_t BufferWidth, uint16_t BufferHeight);
+// Returns the intersection of both rectangles, which is empty (Max <= Min) if they don't overlap.
+Win32ClipRect Win32_IntersectClipRects(const Win32ClipRect& A, const Win32ClipRect& B);
+
+/*
+	Rasterizes a draw call into Surface, only writing pixels within Clip, which must lie within the surface.
+	Returns the count of pixels written, 0 meaning the call was clipped away or empty.
+*/
+uint64_t Win32_ProcessDrawCall(DrawCall& Call, Win32PixelSurface& Surface, const Win32ClipRect& Clip);
+
+// Scales the coordinates and dimensions of a draw call, so that it can be rasterized into a surface of a different size than the one it was made for.
+void Win32_ScaleDrawCall(DrawCall& Call, float ScaleX, float ScaleY);
+
+// Returns whether the bounding box of a draw call lies entirely outside of Clip, meaning it wouldn't touch any pixel.
+bool Win32_IsDrawCallOutsideClip(const DrawCall& Call, const Win32ClipRect& Clip);
+
+/*
+	Clip rectangle change recorded in a draw call buffer, applying to draw calls from the one found at DrawCallPosition onwards.
+	Pushed rectangles are in the coordinates of the viewport's window, already intersected with the rectangle they were pushed over.
+*/
+struct Win32ClipCommand
+{
+	uint32_t DrawCallPosition;
+	uint32_t bPop;
+	Win32ClipRect Rect;
+};
 
 /*
 	Contains all draw calls emitted by the client over a single frame.
@@ -94,11 +361,38 @@ struct Win32DrawCallBuffer
 
 	/*
 		Provided the buffer isn't full, returns the memory address where a draw call of the passed type can be built.
-		Make sure to call BeginWrite() before the first call to NewDrawCall().
+		Make sure to call BeginWrite() before the first call to NewDrawCall(). Calls can be built in any order until EndWrite() is called.
 		Returns nullptr if the buffer is too small to allocate the given draw call type.
 	*/
 	DrawCall* NewDrawCall(DrawCallType Type);
 
+	/*
+		To be called once done writing into the buffer, with every draw call built. Culls draw calls (see CullDrawCalls()).
+	*/
+	void EndWrite();
+
+	/*
+		Restricts the draw calls made from now on to Rect, intersected with the current clip rectangle, until the matching PopClip().
+		Clip commands are stored at the end of the buffer, taking room from draw calls.
+		Returns false if the clip stack or the buffer is full.
+	*/
+	bool PushClip(const Win32ClipRect& Rect);
+
+	// Restores the clip rectangle in place before the last PushClip(). Returns false if there is nothing to pop or the buffer is full.
+	bool PopClip();
+
+	// Returns where draw calls must end, clip commands taking up the rest of the buffer.
+	size_t GetDrawCallLimit() const;
+
+	// Returns the clip command recorded in the passed order, which must be lower than ClipCommandCount.
+	const Win32ClipCommand& GetClipCommand(uint32_t CommandIndex) const;
+
+	/*
+		Removes the draw calls lying entirely outside of the cull area or of the clip rectangle they were made with, moving the calls after them
+		down. Calls can only be tested once the client built them, hence them being culled once writing is done.
+	*/
+	void CullDrawCalls();
+
 	/*
 		To be called before reading through the buffer. Puts the buffer object into a readable state.
 		Returns whether the buffer is readable.
@@ -121,8 +415,310 @@ struct Win32DrawCallBuffer
 
 	// When filling the buffer in, is the write cursor. When reading the buffer, is the read cursor.
 	size_t CursorPosition = 0;
+
+	// Draw calls that didn't fit in the buffer since BeginWrite() was last called.
+	uint32_t RejectedDrawCallCount = 0;
+
+	// Size of the viewport draw calls are made for. Calls falling entirely outside of it get culled. No culling happens while either is 0.
+	uint16_t CullWidth = 0;
+	uint16_t CullHeight = 0;
+
+	// Draw calls culled since BeginWrite() was last called.
+	uint32_t CulledDrawCallCount = 0;
+
+	// Clip commands recorded at the end of the buffer, the first one being last in memory.
+	uint32_t ClipCommandCount = 0;
+
+	// Clip rectangles pushed while writing, the current one being on top. Only used to intersect pushed rectangles with the current one.
+	Win32ClipRect ClipStack[WIN32_CLIP_STACK_CAPACITY];
+	uint32_t ClipDepth = 0;
+};
+
+/*
+	Replays the clip commands of a draw call buffer while reading its draw calls, giving the clip rectangle each call must be rasterized with.
+*/
+struct Win32ClipTracker
+{
+	/*
+		To be called along with the buffer's BeginRead(). Clip rectangles get scaled like the draw calls are (see Win32_ScaleDrawCall()) and
+		limited to Surface.
+	*/
+	void Begin(const Win32DrawCallBuffer& DrawCallBuffer, const Win32PixelSurface& Surface, float ScaleX = 1.f, float ScaleY = 1.f);
+
+	// Returns the clip rectangle of the passed draw call, read from the buffer. Calls must be passed in the order they are read.
+	const Win32ClipRect& GetClip(const DrawCall* Call);
+
+	const Win32DrawCallBuffer* Buffer = nullptr;
+	float ScaleX = 1.f;
+	float ScaleY = 1.f;
+
+	// Clip rectangles in surface coordinates, the bottom one being the whole surface and the current one on top.
+	Win32ClipRect Stack[WIN32_CLIP_STACK_CAPACITY + 1];
+	uint32_t Depth = 0;
+
+	uint32_t NextCommandIndex = 0;
+};
+
+struct PlatformDrawingAPI;
+struct PlatformRenderStatsAPI;
+
+// Return the drawing and rendering statistics functions handed to the client on load. See SynergyPlatformDrawingAPI.h and
+// SynergyPlatformRenderStatsAPI.h. Defined along with viewports.
+const PlatformDrawingAPI& Win32_GetPlatformDrawingAPI();
+const PlatformRenderStatsAPI& Win32_GetPlatformRenderStatsAPI();
+
+// DRAW CALL TRACES
+
+/*
+	Starts capturing draw calls into the file at FilePath, overwriting it. The file is memory-mapped and only ever appended to.
+	Returns whether the trace file could be created.
+*/
+bool Win32_BeginDrawCallCapture(const std::string& FilePath);
+
+/*
+	Appends the content of a viewport's draw call buffer for the given frame to the trace, clip commands included, along with the size of the
+	viewport's window which draw calls are relative to.
+	Must be called after the client is done writing into the buffer and before it gets read for rasterization.
+*/
+void Win32_CaptureDrawCalls(uint64_t FrameNumber, uint32_t ViewportIndex, uint16_t Width, uint16_t Height, const Win32DrawCallBuffer& DrawCallBuffer);
+
+// Ends the capture in progress, if any, trimming the trace file down to its content.
+void Win32_EndDrawCallCapture();
+
+/*
+	Streams the trace at FilePath through the rasterizer, without any client or window, and reports raster time and an image checksum for
+	each frame as well as for the whole trace. Returns whether the trace could be replayed.
+*/
+bool Win32_ReplayDrawCallTrace(const std::string& FilePath);
+
+// FRAMEBUFFER EXPORT
+
+struct Win32FramebufferExportHeader;
+
+// Named shared memory a viewport's pixels get rasterized into, for other local processes to read. See Win32_FramebufferExport_INC.cpp for its layout.
+struct Win32FramebufferExport
+{
+	std::string Name;
+
+	// Shared memory holding the header, and shared memory of the current generation holding the pixels.
+	HANDLE HeaderMapping = NULL;
+	HANDLE PixelMapping = NULL;
+	Win32FramebufferExportHeader* Header = nullptr;
+
+	// Bytes available for pixels.
+	uint64_t PixelCapacity = 0;
+};
+
+/*
+	Creates the shared memory named Name for the header, and shared memory with room for PixelCapacity bytes of pixels to start with.
+	Fails if the names are already in use. Returns whether the export could be opened.
+*/
+bool Win32_OpenFramebufferExport(Win32FramebufferExport& Export, const std::string& Name, uint64_t PixelCapacity);
+
+/*
+	Re-creates Surface in the export's shared memory with the passed size, moving the pixels to larger shared memory first if it doesn't fit.
+	Returns false, leaving Surface released if it was placed in the export, if the export isn't open or larger shared memory can't be created.
+*/
+bool Win32_ResizeExportedPixelSurface(Win32FramebufferExport& Export, Win32PixelSurface& Surface, uint16_t Width, uint16_t Height);
+
+// Marks the start of rendering a frame into the exported surface, so readers know to wait.
+void Win32_BeginExportedFrame(Win32FramebufferExport& Export);
+
+// Marks the end of rendering a frame into Surface, publishing it to readers if it is the exported surface.
+void Win32_EndExportedFrame(Win32FramebufferExport& Export, uint64_t FrameNumber, const Win32PixelSurface& Surface);
+
+// Closes the export. Surfaces placed in it must be released first.
+void Win32_CloseFramebufferExport(Win32FramebufferExport& Export);
+
+// ALLOCATORS
+
+struct PlatformMemoryAPI;
+
+// Logs the usage statistics of every allocator the client has from the platform.
+void Win32_LogAllocatorStats();
+
+// Frees every scratch arena and object pool. The client must be shut down first, and no thread may use allocators afterwards.
+void Win32_FreeAllocators();
+
+// Returns the allocator functions handed to the client on load. See SynergyPlatformMemoryAPI.h.
+const PlatformMemoryAPI& Win32_GetPlatformMemoryAPI();
+
+// ASSET PACK
+
+struct PlatformAssetAPI;
+
+// Asset pack mounted at startup if present, unless another one is given on the command line (-asset-pack <path>).
+#define ASSET_PACK_DEFAULT_PATH "Assets.sypack"
+
+/*
+	Maps the asset pack at FilePath in memory, replacing the mounted one if any, and checks its table of contents. Must be called before the client
+	library is loaded. Returns whether the pack could be mounted.
+*/
+bool Win32_MountAssetPack(const std::string& FilePath);
+
+// Unmaps the mounted asset pack. The client must be shut down first, as it may hold pointers into it.
+void Win32_UnmountAssetPack();
+
+// Returns the asset functions handed to the client on load. See SynergyAssetPack.h.
+const PlatformAssetAPI& Win32_GetPlatformAssetAPI();
+
+// FILE I/O
+
+struct PlatformFileAPI;
+
+/*
+	Starts the worker threads serving the asynchronous file requests of the client. Must be called before the client library is loaded.
+	Returns whether file services could be started.
+*/
+bool Win32_StartFileIO();
+
+// Cancels pending file requests and stops the worker threads. File functions fail from then on.
+void Win32_StopFileIO();
+
+// Returns the file functions handed to the client on load. See SynergyPlatformFileAPI.h.
+const PlatformFileAPI& Win32_GetPlatformFileAPI();
+
+/*
+	Maps the whole file at Path in memory, read only, and sets OutSize to its size. Works whether file services are started or not.
+	Returns nullptr if the file can't be mapped, which includes empty files.
+*/
+const void* Win32_MapFile(const char* Path, uint64_t& OutSize);
+
+// Unmaps memory returned by Win32_MapFile().
+void Win32_UnmapFile(const void* Memory);
+
+// FRAME CAPTURE
+
+/*
+	Starts capturing rendered frames into the file at FilePath, overwriting it. Frames are delta and run-length encoded and written by a
+	background writer thread. Returns whether the capture could be started.
+*/
+bool Win32_BeginFrameCapture(const std::string& FilePath);
+
+/*
+	Main thread only. Copies the visible pixels of the surface into a free capture buffer and queues it for writing. The frame is dropped instead if
+	the writer is too far behind for a buffer to be free. The copy is timed, its cost being reported with the capture statistics.
+*/
+void Win32_CaptureFrame(uint64_t FrameNumber, uint32_t ViewportIndex, const Win32PixelSurface& Surface);
+
+// Ends the capture in progress, if any, waiting for queued frames to be written and reporting capture statistics.
+void Win32_EndFrameCapture();
+
+// INPUT
+
+/*
+	Type of raw input record emitted by the Input thread for the main thread to process.
+*/
+enum class Win32InputRecordType : uint8_t
+{
+	KEY,			// Keyboard key or mouse button transition. Keycode holds the Windows virtual key code.
+	CURSOR_MOVE,	// Cursor moved over a viewport window. X and Y hold the new cursor coordinates.
+	RESIZE,			// Viewport window got resized. X and Y hold the new client area size, SizeType the WM_SIZE request type.
+	VISIBILITY,		// Viewport window got shown or hidden. X is 1 when shown, 0 when hidden.
+	CLOSE			// Viewport window got closed.
+};
+
+/*
+	Raw input record, built by the Input thread from a window message and consumed by the main thread at the start of each frame.
+	Records reference windows rather than viewports as the Input thread never touches viewport data.
+*/
+struct Win32InputRecord
+{
+	Win32InputRecordType Type = Win32InputRecordType::KEY;
+
+	// Window the originating message was sent to.
+	HWND Window = NULL;
+
+	// High resolution timestamp (QueryPerformanceCounter ticks) of when the message was received.
+	int64_t Timestamp = 0;
+
+	uint64_t Keycode = 0;
+	bool bRelease = false;
+
+	uint8_t SizeType = 0;
+	int16_t X = 0;
+	int16_t Y = 0;
 };
 
+/*
+	Lock-free Single Producer / Single Consumer queue of input records. The Input thread is the only producer and the main thread the only consumer.
+	Records must point to an array of Capacity records, Capacity being a power of two.
+*/
+struct Win32InputQueue
+{
+	/*
+		Producer side. Appends a record to the queue.
+		Returns false if the queue is full, in which case it is up to the producer to hold on to the record and try again later.
+	*/
+	bool Push(const Win32InputRecord& Record);
+
+	/*
+		Consumer side. Removes the oldest record from the queue and copies it into OutRecord.
+		Returns false if the queue is empty.
+	*/
+	bool Pop(Win32InputRecord& OutRecord);
+
+	// Consumer side. Returns whether the queue currently holds no record.
+	bool IsEmpty() const;
+
+	Win32InputRecord* Records = nullptr;
+	size_t Capacity = 0;
+
+	// Read and Write indices grow indefinitely and get wrapped on access. They live on separate cache lines to avoid false sharing between threads.
+	alignas(64) std::atomic<size_t> WriteIndex{ 0 };
+	alignas(64) std::atomic<size_t> ReadIndex{ 0 };
+};
+
+// INPUT RECORDING & REPLAY
+
+struct ClientFrameRequestData;
+
+/*
+	Starts recording the input of every frame into the file at FilePath, overwriting it.
+	Returns whether the recording file could be opened.
+*/
+bool Win32_BeginInputRecording(const std::string& FilePath);
+
+// Appends the input of the passed frame (Action Input events, cursor location and frame time) to the recording, if one is in progress.
+void Win32_RecordFrameInput(const ClientFrameRequestData& FrameData);
+
+// Ends the recording in progress, if any.
+void Win32_EndInputRecording();
+
+/*
+	Loads the input recording at FilePath in memory and starts replaying it.
+	Returns whether the file could be loaded and is compatible with this build.
+*/
+bool Win32_BeginInputReplay(const std::string& FilePath);
+
+// Returns whether a replay is in progress.
+bool Win32_IsReplayingInput();
+
+/*
+	Substitutes the next recorded frame's input for the live input in FrameData.
+	Returns false once the end of the recording is reached.
+*/
+bool Win32_ReplayFrameInput(ClientFrameRequestData& FrameData);
+
+// Ends the replay in progress, if any, and frees the recording from memory.
+void Win32_EndInputReplay();
+
+// PERSISTENT MEMORY
+
+/*
+	Maps the file at FilePath in memory to back MemorySize bytes of client persistent memory, creating it if needed. Returns the client memory.
+	If the file holds memory of the same size and LayoutVersion from a previous session and it can be mapped back at the same address, that memory
+	is resumed as is and bOutResumed is set. Otherwise memory starts out zeroed.
+	Returns nullptr on failure.
+*/
+void* Win32_MapPersistentMemoryFile(const std::string& FilePath, size_t MemorySize, uint32_t LayoutVersion, bool& bOutResumed);
+
+// Returns whether client persistent memory is currently backed by a mapped file.
+bool Win32_IsPersistentMemoryFileMapped();
+
+// Flushes client persistent memory to its file and unmaps it.
+void Win32_UnmapPersistentMemoryFile();
+
 // FILE MANAGEMENT
 
 /*
@@ -134,6 +730,17 @@ struct Win32DrawCallBuffer
 */
 bool Win32_CreateTempCopyFile(const std::string& SourcePath, const std::string& DestPath);
 
+/*
+	Makes the file passed as SOURCE available in the Temp Data folder at the provided relative destination path, avoiding copies whenever possible:
+	a hard link is created if the file system allows it, otherwise the file gets copied. Any existing file at the destination is replaced.
+	SourcePath is absolute or relative to current working directory.
+	DestPath is relative to Temp Data folder.
+	OutBytesCopied receives the number of bytes that actually had to be copied, 0 when linking succeeded.
+
+	Returns whether the file is available at the destination.
+*/
+bool Win32_StageTempFile(const std::string& SourcePath, const std::string& DestPath, uint64_t& OutBytesCopied);
+
 /*
 	Deletes a file from the Temp Data folder with the given relative path.
 	FilePath is relative to Temp Data folder.
@@ -141,10 +748,18 @@ bool Win32_CreateTempCopyFile(const std::string& SourcePath, const std::string&
 void Win32_DeleteTempFile(const std::string& FilePath);
 
 /*
-	Deletes the entirety of the Temp Data folder and recreates it. Done at platform initialization.
+	Starts from an empty Temp Data folder. Done at platform initialization.
+	The previous folder is moved aside and deleted on a background thread along with any leftovers from earlier launches, so startup time doesn't
+	depend on how much previous sessions left behind.
 */
 void Win32_ResetTempDataFolder();
 
+/*
+	Stops the background deletion of previous Temp Data folders, waiting for the file being deleted if any. Whatever is left gets deleted by the
+	next launch.
+*/
+void Win32_StopTempDataFolderCleanup();
+
 /*
 	Converts a passed in Temp Data Folder Relative path into a path relative to the current working directory.
 */
@@ -0,0 +1,89 @@
+// Asset pack file format, shared by the asset packer and the platform, and asset functions the platform offers to the client, handed to it on load
+// through its optional "SetPlatformAssetAPI" export. Self-contained so that client libraries can include it as is.
+
+#ifndef SYNERGY_ASSET_PACK_INCLUDED
+#define SYNERGY_ASSET_PACK_INCLUDED
+
+#include <cstdint>
+
+/*
+	Asset packs are laid out as follows, all offsets being from the start of the file:
+	- An AssetPackHeader.
+	- EntryCount AssetPackEntry structures, sorted by name hash so they can be binary searched.
+	- Asset names, normalized (see AssetPackNormalizeNameCharacter()) and null terminated.
+	- Asset data blobs, each starting on an ASSET_PACK_BLOB_ALIGNMENT boundary.
+	Packs are meant to be mapped in memory as is, blobs being used in place.
+*/
+
+// Identifies asset packs ("SYPK" in little endian) and the version of their layout.
+#define ASSET_PACK_MAGIC (0x4B505953)
+#define ASSET_PACK_VERSION (1)
+
+// Alignment of every asset data blob in the pack, in bytes. Mapped packs start on a page boundary so blobs are aligned in memory too.
+#define ASSET_PACK_BLOB_ALIGNMENT (64)
+
+struct AssetPackHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t EntryCount;
+	uint32_t Padding;
+
+	uint64_t EntriesOffset;
+	uint64_t NamesOffset;
+	uint64_t NamesSize;
+};
+
+struct AssetPackEntry
+{
+	uint64_t NameHash;
+
+	// Name of the asset, from the start of the names.
+	uint64_t NameOffset;
+
+	uint64_t DataOffset;
+	uint64_t DataSize;
+};
+
+/*
+	Asset names are relative paths. They are normalized by lowercasing them and turning backslashes into forward slashes, so that lookups don't
+	depend on the platform they're made on.
+*/
+inline char AssetPackNormalizeNameCharacter(char Character)
+{
+	if (Character == '\\')
+	{
+		return '/';
+	}
+	return (Character >= 'A' && Character <= 'Z') ? (char)(Character - 'A' + 'a') : Character;
+}
+
+// Hashes the normalized asset name with 64 bits FNV-1a.
+inline uint64_t AssetPackHashName(const char* Name)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (const char* character = Name; *character != '\0'; character++)
+	{
+		hash ^= (uint8_t)(AssetPackNormalizeNameCharacter(*character));
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/*
+	Table of platform asset functions. Every function can be called from any thread.
+	Returned asset data points straight into the mapped asset pack and stays valid until the client is shut down.
+*/
+struct PlatformAssetAPI
+{
+	// Returns the data of the asset named Name in the mounted asset pack and sets OutSize to its size. nullptr if there is no such asset.
+	const void*(*FindAsset)(const char* Name, uint64_t& OutSize);
+
+	/*
+		Same as FindAsset(), from the name's AssetPackHashName(), so that names can be hashed once ahead of time.
+		Name collisions aren't checked for, the packer refusing to pack names with the same hash.
+	*/
+	const void*(*FindAssetByHash)(uint64_t NameHash, uint64_t& OutSize);
+};
+
+#endif // SYNERGY_ASSET_PACK_INCLUDED
\ No newline at end of file
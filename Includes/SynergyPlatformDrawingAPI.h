@@ -0,0 +1,27 @@
+// Drawing functions the platform offers to the client on top of draw calls, handed to it on load through its optional "SetPlatformDrawingAPI"
+// export. Self-contained so that client libraries can include it as is.
+
+#ifndef SYNERGY_PLATFORM_DRAWING_API_INCLUDED
+#define SYNERGY_PLATFORM_DRAWING_API_INCLUDED
+
+#include <cstdint>
+
+/*
+	Table of platform drawing functions. Functions must be called from the thread running client frames, while a frame runs.
+	Clip rectangles are in the same coordinates as draw calls. They apply to the draw calls made after them, in the order the calls are made,
+	and are reset at the start of every frame.
+*/
+struct PlatformDrawingAPI
+{
+	/*
+		Restricts the draw calls made for the viewport with the passed ID to the Width x Height rectangle at X, Y, intersected with the current
+		clip rectangle, until the matching PopClip(). Draw calls falling entirely outside of it or of the viewport are removed once the frame
+		ends, and count against the draw call buffer's capacity until then. Returns false if there is no such viewport, the clip stack is full or the viewport's draw call buffer is.
+	*/
+	bool(*PushClip)(uint32_t ViewportID, int16_t X, int16_t Y, int16_t Width, int16_t Height);
+
+	// Restores the clip rectangle in place before the last PushClip() for the viewport. Returns false if there was nothing to pop.
+	bool(*PopClip)(uint32_t ViewportID);
+};
+
+#endif // SYNERGY_PLATFORM_DRAWING_API_INCLUDED
\ No newline at end of file
@@ -0,0 +1,59 @@
+// File services the platform offers to the client, handed to it on load through its optional "SetPlatformFileAPI" export.
+// Self-contained so that client libraries can include it as is.
+
+#ifndef SYNERGY_PLATFORM_FILE_API_INCLUDED
+#define SYNERGY_PLATFORM_FILE_API_INCLUDED
+
+#include <cstdint>
+
+/*
+	Identifies an asynchronous file request until its completion gets polled or it gets cancelled. 0 is never a valid request.
+*/
+typedef uint32_t PlatformFileRequestID;
+
+#define PLATFORM_FILE_REQUEST_INVALID_ID (0)
+
+enum class PlatformFileRequestStatus : uint32_t
+{
+	INVALID,	// Unknown request, or one that was already polled to completion or cancelled.
+	PENDING,	// Still being read. Its destination memory must be left alone.
+	COMPLETE,	// Done reading. The request is forgotten once this is returned.
+	FAILED		// Couldn't be read, because the file couldn't be opened or a read failed. The request is forgotten once this is returned.
+};
+
+/*
+	Table of platform file functions. Every function can be called from any thread. Paths are relative to the working directory.
+*/
+struct PlatformFileAPI
+{
+	/*
+		Queues reading up to Size bytes from the file at Path, starting at Offset, into Destination. Reading stops early at the end of the file, so
+		passing the size of the destination with an offset of 0 reads the whole file if it fits.
+		Destination must stay valid until the request is polled to completion or cancelled.
+		Returns PLATFORM_FILE_REQUEST_INVALID_ID if the request can't be queued, such as when too many are pending.
+	*/
+	PlatformFileRequestID(*ReadFileAsync)(const char* Path, uint64_t Offset, uint64_t Size, void* Destination);
+
+	/*
+		Returns the status of the request. Meant to be called once per frame or so for each pending request.
+		OutBytesRead is set to the bytes actually read once the request is COMPLETE.
+	*/
+	PlatformFileRequestStatus(*PollFileRequest)(PlatformFileRequestID Request, uint64_t& OutBytesRead);
+
+	// Cancels the request if it is still pending, waiting for it to stop writing into its destination.
+	void(*CancelFileRequest)(PlatformFileRequestID Request);
+
+	// Blocking. Retrieves the size of the file at Path in bytes. Returns whether the file could be found.
+	bool(*GetFileSize)(const char* Path, uint64_t& OutSize);
+
+	/*
+		Blocking. Maps the whole file at Path in memory, read only, and sets OutSize to its size. Pages get loaded by the OS as they are accessed.
+		Returns nullptr if the file can't be mapped, which includes empty files.
+	*/
+	const void*(*MapFile)(const char* Path, uint64_t& OutSize);
+
+	// Unmaps memory returned by MapFile().
+	void(*UnmapFile)(const void* Memory);
+};
+
+#endif // SYNERGY_PLATFORM_FILE_API_INCLUDED
\ No newline at end of file
@@ -0,0 +1,80 @@
+// Allocators the platform offers to the client, handed to it on load through its optional "SetPlatformMemoryAPI" export.
+// Self-contained so that client libraries can include it as is.
+
+#ifndef SYNERGY_PLATFORM_MEMORY_API_INCLUDED
+#define SYNERGY_PLATFORM_MEMORY_API_INCLUDED
+
+#include <cstdint>
+
+// Position in the calling thread's scratch arena, to reset it back to.
+typedef uint64_t PlatformScratchMark;
+
+// Fixed-size object pool, owned by the platform.
+struct PlatformObjectPool;
+
+enum class PlatformAllocatorType : uint32_t
+{
+	SCRATCH_ARENA,
+	OBJECT_POOL
+};
+
+#define PLATFORM_ALLOCATOR_NAME_CAPACITY (32)
+
+// Usage statistics of a single allocator.
+struct PlatformAllocatorStats
+{
+	char Name[PLATFORM_ALLOCATOR_NAME_CAPACITY];
+	PlatformAllocatorType Type;
+
+	// Bytes the allocator can hand out at most, and bytes currently handed out as well as the most ever handed out at once.
+	uint64_t CapacityBytes;
+	uint64_t BytesInUse;
+	uint64_t PeakBytesInUse;
+
+	// Successful allocations since the allocator got created, and allocations that failed for lack of room.
+	uint64_t AllocationCount;
+	uint64_t FailedAllocationCount;
+};
+
+/*
+	Table of platform allocator functions. Every function can be called from any thread. Allocators outlive client hotreloads, and their memory is
+	only freed once the client is shut down. Memory they return isn't zeroed.
+*/
+struct PlatformMemoryAPI
+{
+	/*
+		Allocates Size bytes aligned on Alignment (a power of two, 0 meaning 16) from the calling thread's scratch arena, which gets created on first
+		use. Scratch memory lasts until the arena is reset to a mark taken before the allocation.
+		Returns nullptr if the arena is out of room.
+	*/
+	void*(*ScratchAllocate)(uint64_t Size, uint64_t Alignment);
+
+	// Returns the current position of the calling thread's scratch arena.
+	PlatformScratchMark(*GetScratchMark)();
+
+	// Frees every scratch allocation the calling thread made since Mark was taken.
+	void(*ResetScratch)(PlatformScratchMark Mark);
+
+	/*
+		Creates a pool of Capacity objects of ObjectSize bytes, each aligned on 16 bytes. Name is used for statistics.
+		Returns nullptr if the pool can't be created.
+	*/
+	PlatformObjectPool*(*CreatePool)(const char* Name, uint64_t ObjectSize, uint32_t Capacity);
+
+	// Destroys the pool, freeing every object in it.
+	void(*DestroyPool)(PlatformObjectPool* Pool);
+
+	// Returns a free object from the pool, or nullptr if all of them are in use.
+	void*(*PoolAllocate)(PlatformObjectPool* Pool);
+
+	// Gives an object back to the pool it was allocated from.
+	void(*PoolFree)(PlatformObjectPool* Pool, void* Object);
+
+	/*
+		Fills OutStats with the statistics of up to MaxCount allocators, scratch arenas first. Returns the count of allocators there are, which can
+		be more than MaxCount.
+	*/
+	uint32_t(*GetAllocatorStats)(PlatformAllocatorStats* OutStats, uint32_t MaxCount);
+};
+
+#endif // SYNERGY_PLATFORM_MEMORY_API_INCLUDED
\ No newline at end of file
@@ -0,0 +1,55 @@
+// Rendering statistics the platform gathers for every viewport, offered to the client through its optional "SetPlatformRenderStatsAPI" export.
+// Self-contained so that client libraries can include it as is.
+
+#ifndef SYNERGY_PLATFORM_RENDER_STATS_API_INCLUDED
+#define SYNERGY_PLATFORM_RENDER_STATS_API_INCLUDED
+
+#include <cstdint>
+
+// Draw call types counted individually, draw call type values at or above it being counted in the total only.
+#define PLATFORM_RENDER_STATS_DRAW_CALL_TYPE_CAPACITY (8)
+
+/*
+	What rendering a viewport took over a frame. Only visible viewports get rasterized, so hidden and minimized ones report no draw calls,
+	only rejected ones.
+*/
+struct PlatformRenderStats
+{
+	// Frame the statistics are about.
+	uint64_t FrameNumber;
+
+	// Draw calls rasterized, in total and per type, indexed by DrawCallType value.
+	uint32_t DrawCallCount;
+	uint32_t DrawCallCountPerType[PLATFORM_RENDER_STATS_DRAW_CALL_TYPE_CAPACITY];
+
+	// Draw calls rasterized that didn't touch a single pixel, being empty or having escaped culling.
+	uint32_t OffscreenDrawCallCount;
+
+	// Draw calls the client couldn't make because the viewport's draw call buffer was full.
+	uint32_t RejectedDrawCallCount;
+
+	/*
+		Draw calls removed from the buffer once the frame ended, their bounding box lying entirely outside of the viewport or of their clip
+		rectangle. They counted against the buffer's capacity until then.
+	*/
+	uint32_t CulledDrawCallCount;
+
+	// Bytes of the viewport's draw call buffer used by the frame, and its size.
+	uint64_t DrawCallBufferBytesUsed;
+	uint64_t DrawCallBufferSize;
+
+	// Pixels written by draw calls, counting pixels as many times as they got overdrawn.
+	uint64_t PixelsWritten;
+};
+
+// Table of platform rendering statistics functions. Functions must be called from the thread running client frames.
+struct PlatformRenderStatsAPI
+{
+	/*
+		Fills OutStats with the statistics of the last frame rendered into the viewport with the passed ID.
+		Returns false if there is no such viewport.
+	*/
+	bool(*GetViewportRenderStats)(uint32_t ViewportID, PlatformRenderStats& OutStats);
+};
+
+#endif // SYNERGY_PLATFORM_RENDER_STATS_API_INCLUDED
\ No newline at end of file
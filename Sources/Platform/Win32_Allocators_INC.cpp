@@ -0,0 +1,350 @@
+SOURCE_INC_FILE()
+
+/*
+	Symbol definitions for the allocators offered to the client (see SynergyPlatformMemoryAPI.h).
+	Scratch arenas reserve a large range of address space per thread and commit it as they grow, so allocating is a pointer bump. Object pools
+	thread a free list through their unused objects.
+*/
+
+#include "SynergyPlatformMemoryAPI.h"
+#include "Platform/Win32_Platform.h"
+
+#include <cstdio>
+#include <vector>
+
+struct Win32ScratchArena
+{
+	uint8_t* Memory = nullptr;
+
+	// Bytes committed from the start of the reservation. Only touched by the owning thread.
+	uint64_t CommittedSize = 0;
+
+	char Name[PLATFORM_ALLOCATOR_NAME_CAPACITY] = {};
+
+	// Also read by threads gathering statistics.
+	std::atomic<uint64_t> UsedSize{ 0 };
+	std::atomic<uint64_t> PeakUsedSize{ 0 };
+	std::atomic<uint64_t> AllocationCount{ 0 };
+	std::atomic<uint64_t> FailedAllocationCount{ 0 };
+};
+
+struct PlatformObjectPool
+{
+	uint8_t* Memory = nullptr;
+
+	// Distance between objects, and count of objects in the pool.
+	uint64_t ObjectStride = 0;
+	uint32_t Capacity = 0;
+
+	char Name[PLATFORM_ALLOCATOR_NAME_CAPACITY] = {};
+
+	SRWLOCK Lock = SRWLOCK_INIT;
+
+	// First free object, each free object starting with a pointer to the next one.
+	void* FirstFreeObject = nullptr;
+
+	uint32_t ObjectsInUse = 0;
+	uint32_t PeakObjectsInUse = 0;
+	uint64_t AllocationCount = 0;
+	uint64_t FailedAllocationCount = 0;
+};
+
+// Every live allocator, for statistics and for freeing them all at once.
+struct Win32AllocatorRegistry
+{
+	SRWLOCK Lock = SRWLOCK_INIT;
+	std::vector<Win32ScratchArena*> ScratchArenas;
+	std::vector<PlatformObjectPool*> Pools;
+};
+
+static Win32AllocatorRegistry Win32Allocators;
+
+// Scratch arena of the calling thread. Threads get theirs on first use and keep it until allocators are freed.
+static thread_local Win32ScratchArena* CurrentScratchArena = nullptr;
+
+// Returns the calling thread's scratch arena, creating it if needed. nullptr if address space can't be reserved for it.
+Win32ScratchArena* GetScratchArena()
+{
+	if (CurrentScratchArena != nullptr)
+	{
+		return CurrentScratchArena;
+	}
+
+	uint8_t* memory = (uint8_t*)(VirtualAlloc(NULL, WIN32_SCRATCH_ARENA_RESERVE_SIZE, MEM_RESERVE, PAGE_NOACCESS));
+	if (memory == nullptr)
+	{
+		std::cerr << "ERROR: Could not reserve memory for a scratch arena. Error Code = " << GetLastError() << "\n";
+		return nullptr;
+	}
+
+	Win32ScratchArena* arena = new Win32ScratchArena();
+	arena->Memory = memory;
+	snprintf(arena->Name, PLATFORM_ALLOCATOR_NAME_CAPACITY, "Scratch (thread %lu)", GetCurrentThreadId());
+
+	AcquireSRWLockExclusive(&Win32Allocators.Lock);
+	Win32Allocators.ScratchArenas.push_back(arena);
+	ReleaseSRWLockExclusive(&Win32Allocators.Lock);
+
+	CurrentScratchArena = arena;
+	return arena;
+}
+
+void* ScratchAllocate(uint64_t Size, uint64_t Alignment)
+{
+	Win32ScratchArena* arena = GetScratchArena();
+	if (arena == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (Alignment == 0)
+	{
+		Alignment = 16;
+	}
+
+	uint64_t usedSize = arena->UsedSize.load(std::memory_order_relaxed);
+	uint64_t allocationOffset = (usedSize + Alignment - 1) & ~(Alignment - 1);
+	if ((Alignment & (Alignment - 1)) != 0 || allocationOffset > WIN32_SCRATCH_ARENA_RESERVE_SIZE || Size > WIN32_SCRATCH_ARENA_RESERVE_SIZE - allocationOffset)
+	{
+		arena->FailedAllocationCount.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	// Commit more of the reservation in steps, so growing doesn't take a system call per allocation.
+	uint64_t newUsedSize = allocationOffset + Size;
+	if (newUsedSize > arena->CommittedSize)
+	{
+		uint64_t newCommittedSize = (newUsedSize + WIN32_SCRATCH_ARENA_COMMIT_STEP - 1) / WIN32_SCRATCH_ARENA_COMMIT_STEP * WIN32_SCRATCH_ARENA_COMMIT_STEP;
+		newCommittedSize = min(newCommittedSize, (uint64_t)(WIN32_SCRATCH_ARENA_RESERVE_SIZE));
+
+		if (VirtualAlloc(arena->Memory + arena->CommittedSize, (SIZE_T)(newCommittedSize - arena->CommittedSize), MEM_COMMIT, PAGE_READWRITE) == nullptr)
+		{
+			arena->FailedAllocationCount.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		arena->CommittedSize = newCommittedSize;
+	}
+
+	arena->UsedSize.store(newUsedSize, std::memory_order_relaxed);
+	if (newUsedSize > arena->PeakUsedSize.load(std::memory_order_relaxed))
+	{
+		arena->PeakUsedSize.store(newUsedSize, std::memory_order_relaxed);
+	}
+	arena->AllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	return arena->Memory + allocationOffset;
+}
+
+PlatformScratchMark GetScratchMark()
+{
+	return CurrentScratchArena != nullptr ? CurrentScratchArena->UsedSize.load(std::memory_order_relaxed) : 0;
+}
+
+void ResetScratch(PlatformScratchMark Mark)
+{
+	// Committed memory is kept, as the arena will most likely grow back to the same size.
+	if (CurrentScratchArena != nullptr && Mark <= CurrentScratchArena->UsedSize.load(std::memory_order_relaxed))
+	{
+		CurrentScratchArena->UsedSize.store(Mark, std::memory_order_relaxed);
+	}
+}
+
+PlatformObjectPool* CreatePool(const char* Name, uint64_t ObjectSize, uint32_t Capacity)
+{
+	if (ObjectSize == 0 || Capacity == 0)
+	{
+		return nullptr;
+	}
+
+	// Free objects hold the free list link, so they must be able to fit a pointer.
+	uint64_t objectStride = (max(ObjectSize, (uint64_t)(sizeof(void*))) + 15) / 16 * 16;
+	uint64_t poolSize = objectStride * Capacity;
+
+	uint8_t* memory = (uint8_t*)(VirtualAlloc(NULL, (SIZE_T)(poolSize), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+	if (memory == nullptr)
+	{
+		std::cerr << "ERROR: Could not allocate " << poolSize << " bytes for object pool \"" << (Name != nullptr ? Name : "") << "\". Error Code = "
+			<< GetLastError() << "\n";
+		return nullptr;
+	}
+
+	PlatformObjectPool* pool = new PlatformObjectPool();
+	pool->Memory = memory;
+	pool->ObjectStride = objectStride;
+	pool->Capacity = Capacity;
+	strncpy_s(pool->Name, PLATFORM_ALLOCATOR_NAME_CAPACITY, Name != nullptr ? Name : "Pool", _TRUNCATE);
+
+	// Thread the free list through every object, first object first.
+	for (uint32_t objectIndex = 0; objectIndex < Capacity; objectIndex++)
+	{
+		*(void**)(memory + objectIndex * objectStride) = objectIndex + 1 < Capacity ? memory + (objectIndex + 1) * objectStride : nullptr;
+	}
+	pool->FirstFreeObject = memory;
+
+	AcquireSRWLockExclusive(&Win32Allocators.Lock);
+	Win32Allocators.Pools.push_back(pool);
+	ReleaseSRWLockExclusive(&Win32Allocators.Lock);
+
+	return pool;
+}
+
+// Frees the pool's memory without unregistering it.
+void FreePool(PlatformObjectPool* Pool)
+{
+	VirtualFree(Pool->Memory, 0, MEM_RELEASE);
+	delete Pool;
+}
+
+void DestroyPool(PlatformObjectPool* Pool)
+{
+	if (Pool == nullptr)
+	{
+		return;
+	}
+
+	AcquireSRWLockExclusive(&Win32Allocators.Lock);
+	for (size_t poolIndex = 0; poolIndex < Win32Allocators.Pools.size(); poolIndex++)
+	{
+		if (Win32Allocators.Pools[poolIndex] == Pool)
+		{
+			Win32Allocators.Pools.erase(Win32Allocators.Pools.begin() + poolIndex);
+			break;
+		}
+	}
+	ReleaseSRWLockExclusive(&Win32Allocators.Lock);
+
+	FreePool(Pool);
+}
+
+void* PoolAllocate(PlatformObjectPool* Pool)
+{
+	if (Pool == nullptr)
+	{
+		return nullptr;
+	}
+
+	AcquireSRWLockExclusive(&Pool->Lock);
+
+	void* object = Pool->FirstFreeObject;
+	if (object != nullptr)
+	{
+		Pool->FirstFreeObject = *(void**)(object);
+		Pool->ObjectsInUse++;
+		Pool->PeakObjectsInUse = max(Pool->PeakObjectsInUse, Pool->ObjectsInUse);
+		Pool->AllocationCount++;
+	}
+	else
+	{
+		Pool->FailedAllocationCount++;
+	}
+
+	ReleaseSRWLockExclusive(&Pool->Lock);
+	return object;
+}
+
+void PoolFree(PlatformObjectPool* Pool, void* Object)
+{
+	if (Pool == nullptr || Object == nullptr)
+	{
+		return;
+	}
+
+	uint64_t objectOffset = (uint8_t*)(Object) - Pool->Memory;
+	if ((uint8_t*)(Object) < Pool->Memory || objectOffset >= Pool->ObjectStride * Pool->Capacity || objectOffset % Pool->ObjectStride != 0)
+	{
+		std::cerr << "ERROR: Attempted to free an object that doesn't belong to pool \"" << Pool->Name << "\".\n";
+		return;
+	}
+
+	AcquireSRWLockExclusive(&Pool->Lock);
+	*(void**)(Object) = Pool->FirstFreeObject;
+	Pool->FirstFreeObject = Object;
+	Pool->ObjectsInUse--;
+	ReleaseSRWLockExclusive(&Pool->Lock);
+}
+
+uint32_t GetAllocatorStats(PlatformAllocatorStats* OutStats, uint32_t MaxCount)
+{
+	AcquireSRWLockShared(&Win32Allocators.Lock);
+
+	uint32_t allocatorCount = (uint32_t)(Win32Allocators.ScratchArenas.size() + Win32Allocators.Pools.size());
+	uint32_t statsIndex = 0;
+
+	for (Win32ScratchArena* arena : Win32Allocators.ScratchArenas)
+	{
+		if (OutStats == nullptr || statsIndex >= MaxCount) break;
+
+		PlatformAllocatorStats& stats = OutStats[statsIndex++];
+		memcpy(stats.Name, arena->Name, PLATFORM_ALLOCATOR_NAME_CAPACITY);
+		stats.Type = PlatformAllocatorType::SCRATCH_ARENA;
+		stats.CapacityBytes = WIN32_SCRATCH_ARENA_RESERVE_SIZE;
+		stats.BytesInUse = arena->UsedSize.load(std::memory_order_relaxed);
+		stats.PeakBytesInUse = arena->PeakUsedSize.load(std::memory_order_relaxed);
+		stats.AllocationCount = arena->AllocationCount.load(std::memory_order_relaxed);
+		stats.FailedAllocationCount = arena->FailedAllocationCount.load(std::memory_order_relaxed);
+	}
+
+	for (PlatformObjectPool* pool : Win32Allocators.Pools)
+	{
+		if (OutStats == nullptr || statsIndex >= MaxCount) break;
+
+		PlatformAllocatorStats& stats = OutStats[statsIndex++];
+		AcquireSRWLockShared(&pool->Lock);
+		memcpy(stats.Name, pool->Name, PLATFORM_ALLOCATOR_NAME_CAPACITY);
+		stats.Type = PlatformAllocatorType::OBJECT_POOL;
+		stats.CapacityBytes = pool->ObjectStride * pool->Capacity;
+		stats.BytesInUse = pool->ObjectStride * pool->ObjectsInUse;
+		stats.PeakBytesInUse = pool->ObjectStride * pool->PeakObjectsInUse;
+		stats.AllocationCount = pool->AllocationCount;
+		stats.FailedAllocationCount = pool->FailedAllocationCount;
+		ReleaseSRWLockShared(&pool->Lock);
+	}
+
+	ReleaseSRWLockShared(&Win32Allocators.Lock);
+	return allocatorCount;
+}
+
+void Win32_LogAllocatorStats()
+{
+	uint32_t allocatorCount = GetAllocatorStats(nullptr, 0);
+	std::vector<PlatformAllocatorStats> allocatorStats(allocatorCount);
+	allocatorCount = min(allocatorCount, GetAllocatorStats(allocatorStats.data(), allocatorCount));
+
+	std::cout << "\tClient Allocators: " << allocatorCount << "\n";
+	for (uint32_t allocatorIndex = 0; allocatorIndex < allocatorCount; allocatorIndex++)
+	{
+		const PlatformAllocatorStats& stats = allocatorStats[allocatorIndex];
+		std::cout << "\t\t" << stats.Name << ": " << stats.BytesInUse << " / " << stats.CapacityBytes << " bytes in use (peak " << stats.PeakBytesInUse
+			<< "), " << stats.AllocationCount << " allocations, " << stats.FailedAllocationCount << " failed.\n";
+	}
+}
+
+void Win32_FreeAllocators()
+{
+	AcquireSRWLockExclusive(&Win32Allocators.Lock);
+
+	for (Win32ScratchArena* arena : Win32Allocators.ScratchArenas)
+	{
+		VirtualFree(arena->Memory, 0, MEM_RELEASE);
+		delete arena;
+	}
+	Win32Allocators.ScratchArenas.clear();
+
+	for (PlatformObjectPool* pool : Win32Allocators.Pools)
+	{
+		FreePool(pool);
+	}
+	Win32Allocators.Pools.clear();
+
+	ReleaseSRWLockExclusive(&Win32Allocators.Lock);
+
+	// Only the calling thread's arena pointer can be reset. Others still point to freed arenas, so no thread may allocate from then on.
+	CurrentScratchArena = nullptr;
+}
+
+const PlatformMemoryAPI& Win32_GetPlatformMemoryAPI()
+{
+	static const PlatformMemoryAPI memoryAPI = { ScratchAllocate, GetScratchMark, ResetScratch, CreatePool, DestroyPool, PoolAllocate, PoolFree,
+		GetAllocatorStats };
+	return memoryAPI;
+}
\ No newline at end of file
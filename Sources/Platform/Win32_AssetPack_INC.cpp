@@ -0,0 +1,168 @@
+SOURCE_INC_FILE()
+
+/*
+	Symbol definitions for mounting an asset pack (see SynergyAssetPack.h). The pack is mapped in memory once and the client gets pointers straight
+	into it, so assets are never copied and only the pages the client touches become resident.
+*/
+
+#include "SynergyAssetPack.h"
+#include "Platform/Win32_Platform.h"
+
+#include <string>
+
+struct Win32AssetPackContext
+{
+	// Mapped pack, and its size in bytes.
+	const uint8_t* Memory = nullptr;
+	uint64_t Size = 0;
+
+	const AssetPackHeader* Header = nullptr;
+	const AssetPackEntry* Entries = nullptr;
+	const char* Names = nullptr;
+};
+
+static Win32AssetPackContext Win32AssetPack;
+
+// Returns the entry with the passed name hash, binary searching the sorted entries. nullptr if there is none.
+const AssetPackEntry* FindAssetPackEntry(uint64_t NameHash)
+{
+	if (Win32AssetPack.Header == nullptr)
+	{
+		return nullptr;
+	}
+
+	uint32_t first = 0;
+	uint32_t last = Win32AssetPack.Header->EntryCount;
+	while (first < last)
+	{
+		uint32_t middle = first + (last - first) / 2;
+		if (Win32AssetPack.Entries[middle].NameHash < NameHash)
+		{
+			first = middle + 1;
+		}
+		else
+		{
+			last = middle;
+		}
+	}
+
+	return first < Win32AssetPack.Header->EntryCount && Win32AssetPack.Entries[first].NameHash == NameHash ? &Win32AssetPack.Entries[first] : nullptr;
+}
+
+const void* FindAssetByHash(uint64_t NameHash, uint64_t& OutSize)
+{
+	const AssetPackEntry* entry = FindAssetPackEntry(NameHash);
+	if (entry == nullptr)
+	{
+		return nullptr;
+	}
+
+	OutSize = entry->DataSize;
+	return Win32AssetPack.Memory + entry->DataOffset;
+}
+
+const void* FindAsset(const char* Name, uint64_t& OutSize)
+{
+	if (Name == nullptr)
+	{
+		return nullptr;
+	}
+
+	const AssetPackEntry* entry = FindAssetPackEntry(AssetPackHashName(Name));
+	if (entry == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Make sure it is the right asset and not one whose name happens to have the same hash.
+	const char* entryName = Win32AssetPack.Names + entry->NameOffset;
+	const char* character = Name;
+	for (; *character != '\0' && *entryName != '\0'; character++, entryName++)
+	{
+		if (AssetPackNormalizeNameCharacter(*character) != *entryName)
+		{
+			return nullptr;
+		}
+	}
+
+	if (*character != *entryName)
+	{
+		return nullptr;
+	}
+
+	OutSize = entry->DataSize;
+	return Win32AssetPack.Memory + entry->DataOffset;
+}
+
+// Returns whether the mapped pack's header, entries and names are consistent with its size, so lookups never read outside of it.
+bool ValidateAssetPack(const uint8_t* Memory, uint64_t Size)
+{
+	if (Size < sizeof(AssetPackHeader))
+	{
+		return false;
+	}
+
+	const AssetPackHeader& header = *(const AssetPackHeader*)(Memory);
+	if (header.Magic != ASSET_PACK_MAGIC || header.Version != ASSET_PACK_VERSION
+		|| header.EntriesOffset > Size || (uint64_t)(header.EntryCount) * sizeof(AssetPackEntry) > Size - header.EntriesOffset
+		|| header.EntriesOffset % alignof(AssetPackEntry) != 0
+		|| header.NamesOffset > Size || header.NamesSize > Size - header.NamesOffset
+		|| (header.NamesSize > 0 && Memory[header.NamesOffset + header.NamesSize - 1] != '\0'))
+	{
+		return false;
+	}
+
+	const AssetPackEntry* entries = (const AssetPackEntry*)(Memory + header.EntriesOffset);
+	for (uint32_t entryIndex = 0; entryIndex < header.EntryCount; entryIndex++)
+	{
+		const AssetPackEntry& entry = entries[entryIndex];
+		if (entry.NameOffset >= header.NamesSize || entry.DataOffset > Size || entry.DataSize > Size - entry.DataOffset
+			|| (entryIndex > 0 && entries[entryIndex - 1].NameHash >= entry.NameHash))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Win32_MountAssetPack(const std::string& FilePath)
+{
+	Win32_UnmountAssetPack();
+
+	uint64_t size = 0;
+	const uint8_t* memory = (const uint8_t*)(Win32_MapFile(FilePath.c_str(), size));
+	if (memory == nullptr)
+	{
+		std::cerr << "ERROR: Could not mount asset pack \"" << FilePath << "\".\n";
+		return false;
+	}
+
+	if (!ValidateAssetPack(memory, size))
+	{
+		std::cerr << "ERROR: \"" << FilePath << "\" isn't a valid asset pack, or was made by an incompatible packer.\n";
+		Win32_UnmapFile(memory);
+		return false;
+	}
+
+	Win32AssetPack.Memory = memory;
+	Win32AssetPack.Size = size;
+	Win32AssetPack.Header = (const AssetPackHeader*)(memory);
+	Win32AssetPack.Entries = (const AssetPackEntry*)(memory + Win32AssetPack.Header->EntriesOffset);
+	Win32AssetPack.Names = (const char*)(memory + Win32AssetPack.Header->NamesOffset);
+
+	std::cout << "Mounted asset pack \"" << FilePath << "\" (" << Win32AssetPack.Header->EntryCount << " assets, " << Win32AssetPack.Size << " bytes).\n";
+	return true;
+}
+
+void Win32_UnmountAssetPack()
+{
+	Win32_UnmapFile(Win32AssetPack.Memory);
+	Win32AssetPack = {};
+}
+
+const PlatformAssetAPI& Win32_GetPlatformAssetAPI()
+{
+	static const PlatformAssetAPI assetAPI = { FindAsset, FindAssetByHash };
+	return assetAPI;
+}
\ No newline at end of file
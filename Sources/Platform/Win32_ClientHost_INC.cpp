@@ -0,0 +1,604 @@
+SOURCE_INC_FILE()
+
+/*
+	Symbol definitions for running the client in a separate client host process, so that a crashing client library doesn't take the platform down.
+	Both processes exchange data through shared memory only: the client host writes draw calls straight into the buffers the platform rasterizes
+	from and reads input from where the platform put it. Events are only used to hand control back and forth.
+*/
+
+#include "SynergyClientAPI.h"
+#include "SynergyPlatformRenderStatsAPI.h"
+#include "Platform/Win32_Platform.h"
+
+#include <string>
+
+// Identifies client host shared memory ("SYCH" in little endian) and the version of its layout.
+#define CLIENT_HOST_MAGIC (0x48435953)
+#define CLIENT_HOST_VERSION (4)
+
+// Input events, draw call buffers and persistent memory start one page into the shared memory.
+#define CLIENT_HOST_HEADER_SIZE (4096)
+
+// Room for the name of a viewport the client host asks the platform to allocate, terminating null included.
+#define CLIENT_HOST_VIEWPORT_NAME_CAPACITY (128)
+
+// Orders given by the platform to the client host, each answered by signaling the Done event.
+enum class Win32ClientHostCommand : uint32_t
+{
+	NONE,
+	START,		// Start the client with the persistent memory found in shared memory.
+	FRAME,		// Run a client frame with the frame properties and input events found in shared memory.
+	SHUTDOWN	// Shut the client down then exit.
+};
+
+// Requests made by the client host to the platform while running a command, each answered by signaling the Reply event.
+enum class Win32ClientHostRequest : uint32_t
+{
+	NONE,
+	ALLOCATE_VIEWPORT,
+	DESTROY_VIEWPORT
+};
+
+/*
+	Header found at the start of client host shared memory. Its fields are only ever accessed by the process that currently has control,
+	control being handed over through the Command, Done, Request and Reply events.
+*/
+struct Win32ClientHostChannelHeader
+{
+	uint32_t Magic = CLIENT_HOST_MAGIC;
+	uint32_t Version = CLIENT_HOST_VERSION;
+
+	// Process the client host should exit with.
+	DWORD PlatformProcessID = 0;
+
+	// Offsets from the start of the shared memory of the Action Input events, the first draw call buffer and the client's persistent memory, in bytes.
+	uint64_t InputEventsOffset = 0;
+	uint64_t DrawCallBuffersOffset = 0;
+	uint64_t PersistentMemoryOffset = 0;
+
+	uint64_t PersistentMemorySize = 0;
+	uint64_t FrameMemorySize = 0;
+
+	Win32ClientHostCommand Command = Win32ClientHostCommand::NONE;
+
+	// Properties of the frame to run, set along with the FRAME command.
+	uint64_t FrameNumber = 0;
+	float FrameTime = 0.f;
+	Vector2s CursorLocation = {};
+	ViewportID CursorViewport = VIEWPORT_ERROR_ID;
+	uint32_t InputEventCount = 0;
+
+	// Size of each viewport, draw calls falling entirely outside of it getting culled. Set by the platform.
+	uint16_t ViewportCullWidths[CLIENT_HOST_MAX_VIEWPORTS] = {};
+	uint16_t ViewportCullHeights[CLIENT_HOST_MAX_VIEWPORTS] = {};
+
+	// Set by the client host once a frame is done.
+	uint32_t IdleWaitMilliseconds = 0;
+	uint32_t RejectedDrawCallCounts[CLIENT_HOST_MAX_VIEWPORTS] = {};
+	uint32_t CulledDrawCallCounts[CLIENT_HOST_MAX_VIEWPORTS] = {};
+	uint32_t ClipCommandCounts[CLIENT_HOST_MAX_VIEWPORTS] = {};
+
+	// Rendering statistics of each viewport's last frame, set by the platform once it is rasterized.
+	PlatformRenderStats ViewportRenderStats[CLIENT_HOST_MAX_VIEWPORTS] = {};
+
+	// Platform request made by the client host and its parameters. RequestViewportID also holds the ID of allocated viewports in reply.
+	Win32ClientHostRequest Request = Win32ClientHostRequest::NONE;
+	char RequestViewportName[CLIENT_HOST_VIEWPORT_NAME_CAPACITY] = {};
+	Vector2s RequestViewportDimensions = {};
+	ViewportID RequestViewportID = VIEWPORT_ERROR_ID;
+};
+
+static_assert(sizeof(Win32ClientHostChannelHeader) <= CLIENT_HOST_HEADER_SIZE, "Client host header must fit before the shared data.");
+
+// Returns the shared memory at the passed offset.
+inline uint8_t* GetClientHostSharedMemory(const Win32ClientHost& Host, uint64_t Offset)
+{
+	return (uint8_t*)(Host.Header) + Offset;
+}
+
+// Opens the events used to hand control between both processes, creating them if needed. Returns whether all of them could be opened.
+bool OpenClientHostEvents(Win32ClientHost& Host)
+{
+	Host.CommandEvent = CreateEventA(NULL, FALSE, FALSE, (Host.Name + "_Command").c_str());
+	Host.DoneEvent = CreateEventA(NULL, FALSE, FALSE, (Host.Name + "_Done").c_str());
+	Host.RequestEvent = CreateEventA(NULL, FALSE, FALSE, (Host.Name + "_Request").c_str());
+	Host.ReplyEvent = CreateEventA(NULL, FALSE, FALSE, (Host.Name + "_Reply").c_str());
+
+	return Host.CommandEvent != NULL && Host.DoneEvent != NULL && Host.RequestEvent != NULL && Host.ReplyEvent != NULL;
+}
+
+// Closes the shared memory, events and process handle of the passed host, without waiting on anything.
+void CloseClientHostHandles(Win32ClientHost& Host)
+{
+	if (Host.Header != nullptr)
+	{
+		UnmapViewOfFile(Host.Header);
+	}
+
+	for (HANDLE handle : { Host.Mapping, Host.CommandEvent, Host.DoneEvent, Host.RequestEvent, Host.ReplyEvent, Host.Process })
+	{
+		if (handle != NULL)
+		{
+			CloseHandle(handle);
+		}
+	}
+
+	Host = {};
+}
+
+// PLATFORM SIDE
+
+// Launches a client host process linked to the passed host's shared memory. Returns whether the process could be created.
+bool LaunchClientHostProcess(Win32ClientHost& Host)
+{
+	char executablePath[MAX_PATH];
+	DWORD executablePathLength = GetModuleFileNameA(NULL, executablePath, MAX_PATH);
+	if (executablePathLength == 0 || executablePathLength == MAX_PATH)
+	{
+		std::cerr << "ERROR: Could not retrieve executable path to launch the client host. Error Code = " << GetLastError() << "\n";
+		return false;
+	}
+
+	// The client host option must come first, see WinMain().
+	std::string commandLine = std::string("\"") + executablePath + "\" -client-host " + Host.Name;
+	if (!Host.LaunchArguments.empty())
+	{
+		commandLine += " " + Host.LaunchArguments;
+	}
+
+	STARTUPINFOA startupInfo = {};
+	startupInfo.cb = sizeof(startupInfo);
+	PROCESS_INFORMATION processInfo = {};
+
+	if (!CreateProcessA(NULL, &commandLine[0], NULL, NULL, FALSE, 0, NULL, NULL, &startupInfo, &processInfo))
+	{
+		std::cerr << "ERROR: Could not launch client host process. Error Code = " << GetLastError() << "\n";
+		return false;
+	}
+
+	CloseHandle(processInfo.hThread);
+	Host.Process = processInfo.hProcess;
+
+	std::cout << "Launched client host process " << processInfo.dwProcessId << ".\n";
+	return true;
+}
+
+// Carries out the request the client host is waiting on, using the platform functions of the session.
+void ServiceClientHostRequest(Win32ClientHost& Host, ClientSessionData& Session)
+{
+	Win32ClientHostChannelHeader& header = *Host.Header;
+
+	switch (header.Request)
+	{
+	case Win32ClientHostRequest::ALLOCATE_VIEWPORT:
+		header.RequestViewportName[CLIENT_HOST_VIEWPORT_NAME_CAPACITY - 1] = '\0';
+		header.RequestViewportID = Session.Platform.AllocateViewport(header.RequestViewportName, header.RequestViewportDimensions);
+		break;
+	case Win32ClientHostRequest::DESTROY_VIEWPORT:
+		Session.Platform.DestroyViewport(header.RequestViewportID);
+		break;
+	default:
+		std::cerr << "WARNING: Ignoring unknown client host request " << (uint32_t)(header.Request) << ".\n";
+		break;
+	}
+
+	header.Request = Win32ClientHostRequest::NONE;
+}
+
+/*
+	Hands control to the client host to carry out the passed command, servicing its requests until it is done.
+	Returns false if the client host crashed or stopped responding, in which case its process is gone.
+*/
+bool RunClientHostCommand(Win32ClientHost& Host, ClientSessionData& Session, Win32ClientHostCommand Command)
+{
+	if (Host.Process == NULL)
+	{
+		return false;
+	}
+
+	Host.Header->Command = Command;
+	SetEvent(Host.CommandEvent);
+
+	HANDLE waitedHandles[] = { Host.DoneEvent, Host.RequestEvent, Host.Process };
+	while (true)
+	{
+		DWORD waitResult = WaitForMultipleObjects(3, waitedHandles, FALSE, CLIENT_HOST_RESPONSE_TIMEOUT_MS);
+
+		if (waitResult == WAIT_OBJECT_0)
+		{
+			return true;
+		}
+		else if (waitResult == WAIT_OBJECT_0 + 1)
+		{
+			ServiceClientHostRequest(Host, Session);
+			SetEvent(Host.ReplyEvent);
+		}
+		else if (waitResult == WAIT_OBJECT_0 + 2)
+		{
+			DWORD exitCode = 0;
+			GetExitCodeProcess(Host.Process, &exitCode);
+			std::cerr << "ERROR: Client host process exited unexpectedly (exit code 0x" << std::hex << exitCode << std::dec << ").\n";
+			break;
+		}
+		else
+		{
+			std::cerr << "ERROR: Client host process stopped responding for " << CLIENT_HOST_RESPONSE_TIMEOUT_MS << " ms. Terminating it.\n";
+			TerminateProcess(Host.Process, 1);
+			WaitForSingleObject(Host.Process, INFINITE);
+			break;
+		}
+	}
+
+	CloseHandle(Host.Process);
+	Host.Process = NULL;
+	return false;
+}
+
+bool Win32_StartClientHost(Win32ClientHost& Host, size_t PersistentMemorySize, size_t FrameMemorySize, const std::string& LaunchArguments)
+{
+	Host = {};
+	Host.Name = "SynergyClientHost_" + std::to_string(GetCurrentProcessId());
+	Host.LaunchArguments = LaunchArguments;
+
+	// Layout: header, input events, draw call buffers, then persistent memory on its own pages.
+	uint64_t inputEventsOffset = CLIENT_HOST_HEADER_SIZE;
+	uint64_t drawCallBuffersOffset = (inputEventsOffset + CLIENT_HOST_INPUT_EVENT_CAPACITY * sizeof(ActionInputEvent) + 63) / 64 * 64;
+	uint64_t persistentMemoryOffset = (drawCallBuffersOffset + (uint64_t)(CLIENT_HOST_MAX_VIEWPORTS) * WIN32_DRAW_CALL_BUFFER_SIZE + 4095) / 4096 * 4096;
+	uint64_t mappingSize = persistentMemoryOffset + PersistentMemorySize;
+
+	Host.Mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(mappingSize >> 32), (DWORD)(mappingSize), Host.Name.c_str());
+	if (Host.Mapping == NULL || GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		std::cerr << "ERROR: Failed to create shared memory \"" << Host.Name << "\" for the client host. Error Code = " << GetLastError() << "\n";
+		CloseClientHostHandles(Host);
+		return false;
+	}
+
+	Host.Header = (Win32ClientHostChannelHeader*)(MapViewOfFile(Host.Mapping, FILE_MAP_WRITE, 0, 0, 0));
+	if (Host.Header == nullptr || !OpenClientHostEvents(Host))
+	{
+		std::cerr << "ERROR: Failed to map shared memory or create events for the client host. Error Code = " << GetLastError() << "\n";
+		CloseClientHostHandles(Host);
+		return false;
+	}
+
+	new (Host.Header) Win32ClientHostChannelHeader();
+	Host.Header->PlatformProcessID = GetCurrentProcessId();
+	Host.Header->InputEventsOffset = inputEventsOffset;
+	Host.Header->DrawCallBuffersOffset = drawCallBuffersOffset;
+	Host.Header->PersistentMemoryOffset = persistentMemoryOffset;
+	Host.Header->PersistentMemorySize = PersistentMemorySize;
+	Host.Header->FrameMemorySize = FrameMemorySize;
+
+	if (!LaunchClientHostProcess(Host))
+	{
+		CloseClientHostHandles(Host);
+		return false;
+	}
+
+	return true;
+}
+
+bool Win32_RestartClientHost(Win32ClientHost& Host)
+{
+	if (Host.Process != NULL)
+	{
+		TerminateProcess(Host.Process, 1);
+		WaitForSingleObject(Host.Process, INFINITE);
+		CloseHandle(Host.Process);
+		Host.Process = NULL;
+	}
+
+	// The new client starts from scratch: memory left by the crashed one can't be trusted, and neither can stale signals.
+	memset(GetClientHostSharedMemory(Host, Host.Header->PersistentMemoryOffset), 0, Host.Header->PersistentMemorySize);
+	Host.Header->Command = Win32ClientHostCommand::NONE;
+	Host.Header->Request = Win32ClientHostRequest::NONE;
+	Host.Header->IdleWaitMilliseconds = 0;
+
+	for (HANDLE event : { Host.CommandEvent, Host.DoneEvent, Host.RequestEvent, Host.ReplyEvent })
+	{
+		ResetEvent(event);
+	}
+
+	return LaunchClientHostProcess(Host);
+}
+
+uint8_t* Win32_GetClientHostPersistentMemory(const Win32ClientHost& Host)
+{
+	return Host.Header != nullptr ? GetClientHostSharedMemory(Host, Host.Header->PersistentMemoryOffset) : nullptr;
+}
+
+uint8_t* Win32_GetClientHostDrawCallBuffer(const Win32ClientHost& Host, uint32_t ViewportIndex)
+{
+	if (Host.Header == nullptr || ViewportIndex >= CLIENT_HOST_MAX_VIEWPORTS)
+	{
+		return nullptr;
+	}
+
+	return GetClientHostSharedMemory(Host, Host.Header->DrawCallBuffersOffset + (uint64_t)(ViewportIndex) * WIN32_DRAW_CALL_BUFFER_SIZE);
+}
+
+bool Win32_RunClientHostStart(Win32ClientHost& Host, ClientSessionData& Session)
+{
+	return RunClientHostCommand(Host, Session, Win32ClientHostCommand::START);
+}
+
+bool Win32_RunClientHostFrame(Win32ClientHost& Host, ClientSessionData& Session, const ClientFrameRequestData& FrameData)
+{
+	if (Host.Header == nullptr)
+	{
+		return false;
+	}
+
+	Win32ClientHostChannelHeader& header = *Host.Header;
+	header.FrameNumber = FrameData.FrameNumber;
+	header.FrameTime = FrameData.FrameTime;
+	header.CursorLocation = FrameData.CursorLocation;
+	header.CursorViewport = FrameData.CursorViewport;
+
+	// Input events are the only frame data that gets copied, and there are only ever a handful of them.
+	size_t inputEventCount = FrameData.ActionInputEvents.EventCount;
+	if (inputEventCount > CLIENT_HOST_INPUT_EVENT_CAPACITY)
+	{
+		std::cerr << "WARNING: Dropping " << inputEventCount - CLIENT_HOST_INPUT_EVENT_CAPACITY << " input events that don't fit in client host memory.\n";
+		inputEventCount = CLIENT_HOST_INPUT_EVENT_CAPACITY;
+	}
+
+	if (inputEventCount > 0)
+	{
+		memcpy(GetClientHostSharedMemory(Host, header.InputEventsOffset), FrameData.ActionInputEvents.Buffer, inputEventCount * sizeof(ActionInputEvent));
+	}
+	header.InputEventCount = (uint32_t)(inputEventCount);
+
+	return RunClientHostCommand(Host, Session, Win32ClientHostCommand::FRAME);
+}
+
+uint32_t Win32_GetClientHostIdleWaitMilliseconds(const Win32ClientHost& Host)
+{
+	return Host.Header != nullptr ? Host.Header->IdleWaitMilliseconds : 0;
+}
+
+void Win32_SetClientHostCullSize(Win32ClientHost& Host, uint32_t ViewportIndex, uint16_t Width, uint16_t Height)
+{
+	if (Host.Header != nullptr && ViewportIndex < CLIENT_HOST_MAX_VIEWPORTS)
+	{
+		Host.Header->ViewportCullWidths[ViewportIndex] = Width;
+		Host.Header->ViewportCullHeights[ViewportIndex] = Height;
+	}
+}
+
+void Win32_SyncClientHostDrawCallBuffer(const Win32ClientHost& Host, uint32_t ViewportIndex, Win32DrawCallBuffer& Buffer)
+{
+	if (Host.Header == nullptr || ViewportIndex >= CLIENT_HOST_MAX_VIEWPORTS)
+	{
+		return;
+	}
+
+	Buffer.RejectedDrawCallCount = Host.Header->RejectedDrawCallCounts[ViewportIndex];
+	Buffer.CulledDrawCallCount = Host.Header->CulledDrawCallCounts[ViewportIndex];
+
+	// The count comes from another process, so it is kept from pointing clip commands outside of the buffer.
+	Buffer.ClipCommandCount = (uint32_t)(min((size_t)(Host.Header->ClipCommandCounts[ViewportIndex]), Buffer.BufferSize / sizeof(Win32ClipCommand)));
+}
+
+void Win32_SetClientHostRenderStats(Win32ClientHost& Host, uint32_t ViewportIndex, const PlatformRenderStats& Stats)
+{
+	if (Host.Header != nullptr && ViewportIndex < CLIENT_HOST_MAX_VIEWPORTS)
+	{
+		Host.Header->ViewportRenderStats[ViewportIndex] = Stats;
+	}
+}
+
+void Win32_StopClientHost(Win32ClientHost& Host, ClientSessionData& Session)
+{
+	if (Host.Process != NULL && RunClientHostCommand(Host, Session, Win32ClientHostCommand::SHUTDOWN)
+		&& WaitForSingleObject(Host.Process, CLIENT_HOST_RESPONSE_TIMEOUT_MS) != WAIT_OBJECT_0)
+	{
+		std::cerr << "WARNING: Client host process didn't exit after shutting down. Terminating it.\n";
+		TerminateProcess(Host.Process, 1);
+	}
+
+	CloseClientHostHandles(Host);
+}
+
+// CLIENT HOST SIDE
+
+// Link to the platform process, for the platform function stand-ins given to the client below.
+static Win32ClientHost* ClientHostLink = nullptr;
+
+// Draw call buffers placed in shared memory, one per viewport slot. The platform zeroes them out before each frame.
+static Win32DrawCallBuffer ClientHostDrawCallBuffers[CLIENT_HOST_MAX_VIEWPORTS];
+
+// Hands control to the platform to carry out the request set in the header, waiting for its reply. Returns false if the platform is gone.
+bool SendClientHostRequest(Win32ClientHostRequest Request)
+{
+	ClientHostLink->Header->Request = Request;
+	SetEvent(ClientHostLink->RequestEvent);
+
+	HANDLE waitedHandles[] = { ClientHostLink->ReplyEvent, ClientHostLink->Process };
+	return WaitForMultipleObjects(2, waitedHandles, FALSE, INFINITE) == WAIT_OBJECT_0;
+}
+
+ViewportID ClientHostAllocateViewport(const char* Name, Vector2s Dimensions)
+{
+	Win32ClientHostChannelHeader& header = *ClientHostLink->Header;
+	strncpy_s(header.RequestViewportName, CLIENT_HOST_VIEWPORT_NAME_CAPACITY, Name != nullptr ? Name : "", _TRUNCATE);
+	header.RequestViewportDimensions = Dimensions;
+	header.RequestViewportID = VIEWPORT_ERROR_ID;
+
+	if (!SendClientHostRequest(Win32ClientHostRequest::ALLOCATE_VIEWPORT))
+	{
+		return VIEWPORT_ERROR_ID;
+	}
+
+	// Viewports past the shared draw call buffers can't be drawn into from here, so the platform never hands them out.
+	return header.RequestViewportID;
+}
+
+void ClientHostDestroyViewport(ViewportID ID)
+{
+	ClientHostLink->Header->RequestViewportID = ID;
+	SendClientHostRequest(Win32ClientHostRequest::DESTROY_VIEWPORT);
+}
+
+Win32DrawCallBuffer* Win32_GetHostedClientDrawCallBuffer(uint32_t ViewportIndex)
+{
+	return ClientHostLink != nullptr && ViewportIndex < CLIENT_HOST_MAX_VIEWPORTS ? &ClientHostDrawCallBuffers[ViewportIndex] : nullptr;
+}
+
+bool Win32_GetClientHostRenderStats(uint32_t ViewportIndex, PlatformRenderStats& OutStats)
+{
+	// Statistics are only read while running a command, the platform waiting on the client host meanwhile.
+	if (ClientHostLink == nullptr || ViewportIndex >= CLIENT_HOST_MAX_VIEWPORTS)
+	{
+		return false;
+	}
+
+	OutStats = ClientHostLink->Header->ViewportRenderStats[ViewportIndex];
+	return true;
+}
+
+int Win32_RunClientHost(const std::string& Name, SynergyClientAPI& API)
+{
+	Win32ClientHost host = {};
+	host.Name = Name;
+
+	host.Mapping = OpenFileMappingA(FILE_MAP_WRITE, FALSE, Name.c_str());
+	host.Header = host.Mapping != NULL ? (Win32ClientHostChannelHeader*)(MapViewOfFile(host.Mapping, FILE_MAP_WRITE, 0, 0, 0)) : nullptr;
+	if (host.Header == nullptr || host.Header->Magic != CLIENT_HOST_MAGIC || host.Header->Version != CLIENT_HOST_VERSION || !OpenClientHostEvents(host))
+	{
+		std::cerr << "FATAL ERROR: Could not open client host shared memory \"" << Name << "\". Error Code = " << GetLastError() << "\n";
+		CloseClientHostHandles(host);
+		return 1;
+	}
+
+	// Exit along with the platform, whatever happens to it.
+	host.Process = OpenProcess(SYNCHRONIZE, FALSE, host.Header->PlatformProcessID);
+	if (host.Process == NULL)
+	{
+		std::cerr << "FATAL ERROR: Could not open platform process. Error Code = " << GetLastError() << "\n";
+		CloseClientHostHandles(host);
+		return 1;
+	}
+
+	ClientHostLink = &host;
+
+	for (uint32_t viewportIndex = 0; viewportIndex < CLIENT_HOST_MAX_VIEWPORTS; viewportIndex++)
+	{
+		ClientHostDrawCallBuffers[viewportIndex].Buffer = Win32_GetClientHostDrawCallBuffer(host, viewportIndex);
+		ClientHostDrawCallBuffers[viewportIndex].BufferSize = WIN32_DRAW_CALL_BUFFER_SIZE;
+	}
+
+	ClientSessionData sessionData = {};
+	sessionData.PersistentMemoryBuffer.Memory = Win32_GetClientHostPersistentMemory(host);
+	sessionData.PersistentMemoryBuffer.Size = host.Header->PersistentMemorySize;
+	sessionData.Platform.AllocateViewport = ClientHostAllocateViewport;
+	sessionData.Platform.DestroyViewport = ClientHostDestroyViewport;
+
+	// Frame memory gets reused from frame to frame, zeroed out before each.
+	size_t frameMemorySize = host.Header->FrameMemorySize;
+	uint8_t* frameMemory = (uint8_t*)(malloc(frameMemorySize));
+	if (frameMemory == nullptr)
+	{
+		std::cerr << "FATAL ERROR: Failed to allocate memory for Frame Memory !\n";
+		CloseClientHostHandles(host);
+		return 1;
+	}
+
+#if HOTRELOAD_SUPPORTED
+	// New client library versions get picked up here, between frames, as the platform doesn't load the library.
+	Win32_StartHotreloadWatcher();
+#endif
+
+	HANDLE waitedHandles[] = { host.CommandEvent, host.Process };
+	bool bRunning = true;
+	while (bRunning && WaitForMultipleObjects(2, waitedHandles, FALSE, INFINITE) == WAIT_OBJECT_0)
+	{
+		Win32ClientHostChannelHeader& header = *host.Header;
+
+		switch (header.Command)
+		{
+		case Win32ClientHostCommand::START:
+			if (API.APISuccessfullyLoaded())
+			{
+				API.StartClient(sessionData);
+			}
+			break;
+
+		case Win32ClientHostCommand::FRAME:
+		{
+#if HOTRELOAD_SUPPORTED
+			Win32_HotreloadClientModuleIfReady(API);
+#endif
+
+			memset(frameMemory, 0, frameMemorySize);
+
+			ClientFrameRequestData frameData = {};
+			frameData.FrameMemoryBuffer.Memory = frameMemory;
+			frameData.FrameMemoryBuffer.Size = frameMemorySize;
+			frameData.FrameNumber = header.FrameNumber;
+			frameData.FrameTime = header.FrameTime;
+			frameData.CursorLocation = header.CursorLocation;
+			frameData.CursorViewport = header.CursorViewport;
+			frameData.ActionInputEvents.Buffer = (ActionInputEvent*)(GetClientHostSharedMemory(host, header.InputEventsOffset));
+			frameData.ActionInputEvents.EventCount = header.InputEventCount;
+
+			frameData.NewDrawCall = [](ViewportID TargetViewportID, DrawCallType Type)
+				{
+					return TargetViewportID < CLIENT_HOST_MAX_VIEWPORTS ? ClientHostDrawCallBuffers[TargetViewportID].NewDrawCall(Type) : nullptr;
+				};
+
+			// Buffers were zeroed out by the platform, only the write cursors and counters need resetting.
+			for (uint32_t viewportIndex = 0; viewportIndex < CLIENT_HOST_MAX_VIEWPORTS; viewportIndex++)
+			{
+				Win32DrawCallBuffer& drawCallBuffer = ClientHostDrawCallBuffers[viewportIndex];
+				drawCallBuffer.CursorPosition = 0;
+				drawCallBuffer.RejectedDrawCallCount = 0;
+				drawCallBuffer.CulledDrawCallCount = 0;
+				drawCallBuffer.ClipCommandCount = 0;
+				drawCallBuffer.ClipDepth = 0;
+				drawCallBuffer.CullWidth = header.ViewportCullWidths[viewportIndex];
+				drawCallBuffer.CullHeight = header.ViewportCullHeights[viewportIndex];
+			}
+
+			if (API.APISuccessfullyLoaded())
+			{
+				API.RunClientFrame(sessionData, frameData);
+			}
+
+			header.IdleWaitMilliseconds = Win32_GetClientIdleWaitMilliseconds(sessionData);
+			for (uint32_t viewportIndex = 0; viewportIndex < CLIENT_HOST_MAX_VIEWPORTS; viewportIndex++)
+			{
+				ClientHostDrawCallBuffers[viewportIndex].EndWrite();
+				header.RejectedDrawCallCounts[viewportIndex] = ClientHostDrawCallBuffers[viewportIndex].RejectedDrawCallCount;
+				header.CulledDrawCallCounts[viewportIndex] = ClientHostDrawCallBuffers[viewportIndex].CulledDrawCallCount;
+				header.ClipCommandCounts[viewportIndex] = ClientHostDrawCallBuffers[viewportIndex].ClipCommandCount;
+			}
+			break;
+		}
+
+		case Win32ClientHostCommand::SHUTDOWN:
+			if (API.APISuccessfullyLoaded())
+			{
+				API.ShutdownClient(sessionData);
+			}
+			bRunning = false;
+			break;
+
+		default:
+			std::cerr << "WARNING: Ignoring unknown client host command " << (uint32_t)(header.Command) << ".\n";
+			break;
+		}
+
+		header.Command = Win32ClientHostCommand::NONE;
+		SetEvent(host.DoneEvent);
+	}
+
+#if HOTRELOAD_SUPPORTED
+	Win32_StopHotreloadWatcher();
+#endif
+
+	free(frameMemory);
+	ClientHostLink = nullptr;
+	CloseClientHostHandles(host);
+	return 0;
@@ -2,7 +2,12 @@ SOURCE_INC_FILE()
 
 // Synergy Client Module & API Loading implementation. The symbols are referenced and used in Win32_Main.cpp.
 
+#include "SynergyAssetPack.h"
 #include "SynergyClientAPI.h"
+#include "SynergyPlatformDrawingAPI.h"
+#include "SynergyPlatformFileAPI.h"
+#include "SynergyPlatformMemoryAPI.h"
+#include "SynergyPlatformRenderStatsAPI.h"
 #include "Platform/Win32_Platform.h"
 
 #include <iostream>
@@ -13,10 +18,59 @@ SOURCE_INC_FILE()
 // Base name for the Client dynamic library file. The actual file will possibly have a suffix with its version and build time identification.
 #define CLIENT_MODULE_FILENAME_BASE "SynergyClientLib"
 
+// CLIENT LIBRARY LOADER BACKEND
+// Thin layer over the OS dynamic library facilities, which is all the loading & hotreloading code below relies on.
+
+// File extensions of client library and debug symbols files, and characters separating folders in paths.
+#define CLIENT_LIBRARY_FILE_EXTENSION ".dll"
+#define CLIENT_SYMBOLS_FILE_EXTENSION ".pdb"
+#define PATH_SEPARATORS "\\/"
+
+typedef HMODULE ClientLibraryHandle;
+
+// Loads the dynamic library at the passed path. Returns NULL on failure.
+ClientLibraryHandle OpenClientLibrary(const std::string& LibPath)
+{
+	return LoadLibraryA(LibPath.c_str());
+}
+
+// Returns the address of the passed exported symbol in the library, or nullptr if it can't be found.
+void* GetClientLibrarySymbol(ClientLibraryHandle Library, const char* SymbolName)
+{
+	return (void*)(GetProcAddress(Library, SymbolName));
+}
+
+// Unloads the passed library.
+void CloseClientLibrary(ClientLibraryHandle Library)
+{
+	if (Library != NULL)
+	{
+		FreeLibrary(Library);
+	}
+}
+
+// Returns the current value of the high resolution timer, in milliseconds.
+double GetLoaderTimeMilliseconds()
+{
+	LARGE_INTEGER timestamp, performanceFrequency;
+	QueryPerformanceCounter(&timestamp);
+	QueryPerformanceFrequency(&performanceFrequency);
+	return timestamp.QuadPart * 1000.0 / performanceFrequency.QuadPart;
+}
+
+// --------------------------------------
+
 /*
 	Module identifier for the currently loaded Client library module, if any.
 */
-HMODULE ClientLibModule = NULL;
+ClientLibraryHandle ClientLibModule = NULL;
+
+/*
+	Optional export of the currently loaded Client library telling for how long it can go without running a frame, resolved on load as it gets
+	called every frame. nullptr if the library doesn't export it.
+*/
+typedef uint32_t(*ClientGetIdleWaitMillisecondsFunction)(ClientSessionData& Session);
+ClientGetIdleWaitMillisecondsFunction ClientGetIdleWaitMilliseconds = nullptr;
 
 #if HOTRELOAD_SUPPORTED
 
@@ -63,12 +117,37 @@ struct Win32HotreloadSystemContext
 		Whether the Hot Reload Compile Setup script has been ran on not.
 	*/
 	bool bCompileSetupScriptRan = false;
+
+	/*
+		Thread watching the source folder for changes to the client library, and event used to ask it to stop.
+	*/
+	HANDLE WatcherThread = NULL;
+	HANDLE WatcherStopEvent = NULL;
+
+	/*
+		Set by the watcher thread once a new client library is complete and ready to be hotreloaded, consumed by the main thread on frame boundaries.
+	*/
+	std::atomic<bool> bNewLibraryReady{ false };
+
+	/*
+		Process of the hotreload compile script currently running in the background, if any, and the time it was launched at.
+	*/
+	HANDLE CompileProcess = NULL;
+	LARGE_INTEGER CompileStartTimestamp = {};
 };
 
 static Win32HotreloadSystemContext Win32HotreloadContext;
 
 #endif
 
+// Calls Setter, an exported client function taking a platform API table of type APIType, with the table returned by GetAPI.
+template<typename APIType, const APIType&(*GetAPI)()>
+void HandPlatformAPIToClient(void* Setter)
+{
+	typedef void(*ClientSetPlatformAPIFunction)(const APIType& API);
+	((ClientSetPlatformAPIFunction)(Setter))(GetAPI());
+}
+
 void Win32_LoadClientModule(SynergyClientAPI& APIStruct, std::string LibNameOverride)
 {
 	APIStruct = {};
@@ -79,38 +158,67 @@ void Win32_LoadClientModule(SynergyClientAPI& APIStruct, std::string LibNameOver
 		LibName = LibNameOverride;
 	}
 
-	ClientLibModule = LoadLibraryA(LibName.c_str());
-	if (ClientLibModule == nullptr)
+	ClientLibModule = OpenClientLibrary(LibName);
+	if (ClientLibModule == NULL)
 	{
 		std::cerr << "Error: Couldn't load Client Library. Make sure \"" << LibName << "\" exists in working directory.\n";
 		return;
 	}
 
-	// Load Client API functions.
+	// Load Client API functions, resolving every symbol from a single table into the matching API Struct member.
 	APIStruct = {};
 
-	APIStruct.Hello = decltype(APIStruct.Hello)(GetProcAddress(ClientLibModule, "Hello"));
-	if (APIStruct.Hello == nullptr)
+	struct ClientAPISymbol
 	{
-		std::cerr << "Error: Missing symbol \"Hello\" in Client library.\n";
-	}
+		const char* Name;
+		void** Address;
+	};
 
-	APIStruct.StartClient = decltype(APIStruct.StartClient)(GetProcAddress(ClientLibModule, "StartClient"));
-	if (APIStruct.StartClient == nullptr)
+	const ClientAPISymbol apiSymbols[] =
 	{
-		std::cerr << "Error: Missing symbol \"CreateClientContext\" in Client library.\n";
-	}
+		{ "Hello", (void**)(&APIStruct.Hello) },
+		{ "StartClient", (void**)(&APIStruct.StartClient) },
+		{ "RunClientFrame", (void**)(&APIStruct.RunClientFrame) },
+		{ "ShutdownClient", (void**)(&APIStruct.ShutdownClient) },
+	};
 
-	APIStruct.RunClientFrame = decltype(APIStruct.RunClientFrame)(GetProcAddress(ClientLibModule, "RunClientFrame"));
-	if (APIStruct.RunClientFrame == nullptr)
+	for (const ClientAPISymbol& symbol : apiSymbols)
 	{
-		std::cerr << "Error: Missing symbol \"RunClientFrame \" in Client library.\n";
+		*symbol.Address = GetClientLibrarySymbol(ClientLibModule, symbol.Name);
+		if (*symbol.Address == nullptr)
+		{
+			std::cerr << "Error: Missing symbol \"" << symbol.Name << "\" in Client library.\n";
+		}
 	}
 
-	APIStruct.ShutdownClient = decltype(APIStruct.ShutdownClient)(GetProcAddress(ClientLibModule, "ShutdownClient"));
-	if (APIStruct.ShutdownClient == nullptr)
+	ClientGetIdleWaitMilliseconds = (ClientGetIdleWaitMillisecondsFunction)(GetClientLibrarySymbol(ClientLibModule, "GetIdleWaitMilliseconds"));
+
+	/*
+		Hand platform services to the client through the optional setters it exports. This happens on every load so hotreloaded libraries get
+		them too. Allocators live on across reloads, so the client can keep using what it allocated from them.
+	*/
+	struct ClientServiceSetter
+	{
+		const char* Name;
+		void(*HandOver)(void* Setter);
+	};
+
+	const ClientServiceSetter serviceSetters[] =
+	{
+		{ "SetPlatformFileAPI", HandPlatformAPIToClient<PlatformFileAPI, Win32_GetPlatformFileAPI> },
+		{ "SetPlatformAssetAPI", HandPlatformAPIToClient<PlatformAssetAPI, Win32_GetPlatformAssetAPI> },
+		{ "SetPlatformMemoryAPI", HandPlatformAPIToClient<PlatformMemoryAPI, Win32_GetPlatformMemoryAPI> },
+		{ "SetPlatformDrawingAPI", HandPlatformAPIToClient<PlatformDrawingAPI, Win32_GetPlatformDrawingAPI> },
+		{ "SetPlatformRenderStatsAPI", HandPlatformAPIToClient<PlatformRenderStatsAPI, Win32_GetPlatformRenderStatsAPI> },
+	};
+
+	for (const ClientServiceSetter& serviceSetter : serviceSetters)
 	{
-		std::cerr << "Error: Missing symbol \"ShutdownClient \" in Client library.\n";
+		void* setter = GetClientLibrarySymbol(ClientLibModule, serviceSetter.Name);
+		if (setter != nullptr)
+		{
+			serviceSetter.HandOver(setter);
+		}
 	}
 
 	if (APIStruct.APISuccessfullyLoaded())
@@ -122,8 +230,9 @@ void Win32_LoadClientModule(SynergyClientAPI& APIStruct, std::string LibNameOver
 
 void Win32_UnloadClientModule(SynergyClientAPI& API)
 {
-	FreeLibrary(ClientLibModule);
+	CloseClientLibrary(ClientLibModule);
 	ClientLibModule = NULL;
+	ClientGetIdleWaitMilliseconds = nullptr;
 
 	/*
 		Assign "stub" lambdas to all API functions so they do not crash the program if called mistakenly.
@@ -136,6 +245,43 @@ void Win32_UnloadClientModule(SynergyClientAPI& API)
 	API.ShutdownClient = [](ClientSessionData& Context) {};
 }
 
+uint32_t Win32_GetClientPersistentMemoryLayoutVersion()
+{
+	if (ClientLibModule == NULL)
+	{
+		return 0;
+	}
+
+	typedef uint32_t(*GetPersistentMemoryLayoutVersionFunction)();
+	GetPersistentMemoryLayoutVersionFunction getLayoutVersion = 
+		(GetPersistentMemoryLayoutVersionFunction)(GetClientLibrarySymbol(ClientLibModule, "GetPersistentMemoryLayoutVersion"));
+
+	return getLayoutVersion != nullptr ? getLayoutVersion() : 0;
+}
+
+bool Win32_ResumeClient(ClientSessionData& Session)
+{
+	if (ClientLibModule == NULL)
+	{
+		return false;
+	}
+
+	typedef void(*ResumeClientFunction)(ClientSessionData& Session);
+	ResumeClientFunction resumeClient = (ResumeClientFunction)(GetClientLibrarySymbol(ClientLibModule, "ResumeClient"));
+	if (resumeClient == nullptr)
+	{
+		return false;
+	}
+
+	resumeClient(Session);
+	return true;
+}
+
+uint32_t Win32_GetClientIdleWaitMilliseconds(ClientSessionData& Session)
+{
+	return ClientGetIdleWaitMilliseconds != nullptr ? ClientGetIdleWaitMilliseconds(Session) : 0;
+}
+
 #if HOTRELOAD_SUPPORTED
 
 void Win32_CleanupHotreloadFiles()
@@ -147,9 +293,10 @@ void Win32_CleanupHotreloadFiles()
 void HotreloadClientModule(SynergyClientAPI& API, std::string sourceLibFilePath)
 {
 	std::cout << "Hotreloading Synergy Client Module.\n";
+	double hotreloadStartTime = GetLoaderTimeMilliseconds();
 
 	// Retrieve file name from path.
-	size_t lastFolderSeparatorIndex = sourceLibFilePath.find_last_of('\\');
+	size_t lastFolderSeparatorIndex = sourceLibFilePath.find_last_of(PATH_SEPARATORS);
 
 	std::string sourceFileName;
 	std::string sourceFolder;
@@ -173,16 +320,20 @@ void HotreloadClientModule(SynergyClientAPI& API, std::string sourceLibFilePath)
 	}
 
 	// Determine "candidate" file names and paths which will be the targets of copying and loading.
-	std::string candidateLibFileName = sourceFileName + ".dll";
-	std::string candidateSymbolsFileName = sourceFileName + ".pdb";
+	std::string candidateLibFileName = sourceFileName + CLIENT_LIBRARY_FILE_EXTENSION;
+	std::string candidateSymbolsFileName = sourceFileName + CLIENT_SYMBOLS_FILE_EXTENSION;
 
 	// Assume that a .pdb file with the same file name as the source file will be found in the same folder.
 	std::string sourceSymbolsFilePath = sourceFolder + candidateSymbolsFileName;
 
 	bool bCopyFailed = false;
 
-	// Copy .dll
-	if (!Win32_CreateTempCopyFile(sourceLibFilePath, candidateLibFileName))
+	// Stage files into the Temp folder. Hard links are used whenever possible, so most of the time nothing actually gets copied.
+	uint64_t libBytesCopied = 0;
+	uint64_t symbolsBytesCopied = 0;
+
+	// Stage .dll
+	if (!Win32_StageTempFile(sourceLibFilePath, candidateLibFileName, libBytesCopied))
 	{
 		if (GetLastError() != ERROR_SHARING_VIOLATION)
 		{
@@ -192,8 +343,8 @@ void HotreloadClientModule(SynergyClientAPI& API, std::string sourceLibFilePath)
 		
 		bCopyFailed = true;
 	}
-	// Copy .pdb symbols.
-	else if (!Win32_CreateTempCopyFile(sourceSymbolsFilePath, candidateSymbolsFileName))
+	// Stage .pdb symbols.
+	else if (!Win32_StageTempFile(sourceSymbolsFilePath, candidateSymbolsFileName, symbolsBytesCopied))
 	{
 		if (GetLastError() != ERROR_SHARING_VIOLATION)
 		{
@@ -208,7 +359,13 @@ void HotreloadClientModule(SynergyClientAPI& API, std::string sourceLibFilePath)
 		return;
 	}
 
-	// Unload client module, which will either unload the base library if this is the first hotreload or unload and delete the previous hotreload iteration.
+	std::cout << "Staged client module files (" << libBytesCopied + symbolsBytesCopied << " bytes copied).\n";
+
+	/*
+		Swap starts here: from this point on and until the new module is loaded, no client module is available.
+		Unload client module, which will either unload the base library if this is the first hotreload or unload and delete the previous hotreload iteration.
+	*/
+	double swapStartTime = GetLoaderTimeMilliseconds();
 	Win32_UnloadClientModule(API);
 
 	// If we were using a hotreloading iteration, delete it.
@@ -223,13 +380,20 @@ void HotreloadClientModule(SynergyClientAPI& API, std::string sourceLibFilePath)
 	std::string loadedSymbolsPath = Win32_ConvertTempPathToRelativePath(candidateSymbolsFileName);
 	Win32_LoadClientModule(API, loadedLibPath);
 
+	double hotreloadEndTime = GetLoaderTimeMilliseconds();
+
 	if (API.APISuccessfullyLoaded())
 	{
-		std::cout << "Synergy Client Module hot-reloaded successfully.\n";
+		std::cout << "Synergy Client Module hot-reloaded successfully in " << hotreloadEndTime - hotreloadStartTime << " ms (module swap took "
+			<< hotreloadEndTime - swapStartTime << " ms).\n";
 		
 		// Cache the last write time of the file for automated change detection and filename.
-		WIN32_FIND_DATAA fileFindData;
-		FindFirstFileA(loadedLibPath.c_str(), &fileFindData);
+		WIN32_FIND_DATAA fileFindData = {};
+		HANDLE fileFindHandle = FindFirstFileA(loadedLibPath.c_str(), &fileFindData);
+		if (fileFindHandle != INVALID_HANDLE_VALUE)
+		{
+			FindClose(fileFindHandle);
+		}
 
 		Win32HotreloadContext.LibFilename = loadedLibPath;
 		Win32HotreloadContext.LastLoadedClientLibraryFileWriteTime = fileFindData.ftLastWriteTime;
@@ -245,10 +409,16 @@ void HotreloadClientModule(SynergyClientAPI& API, std::string sourceLibFilePath)
 	}
 }
 
-void RunHotreloadCompileProgram()
+void Win32_StartHotreloadCompile()
 {
 	// Run Hotreload script if one is defined.
 #ifdef CLIENT_MODULE_HOTRELOAD_COMPILE_SCRIPT
+	if (Win32HotreloadContext.CompileProcess != NULL)
+	{
+		std::cout << "Client Hotreload Recompile script is already running.\n";
+		return;
+	}
+
 	SHELLEXECUTEINFOA execInfo = {};
 	execInfo.cbSize = sizeof(SHELLEXECUTEINFO);
 	execInfo.fMask = SEE_MASK_NOCLOSEPROCESS | SEE_MASK_NO_CONSOLE;
@@ -258,36 +428,81 @@ void RunHotreloadCompileProgram()
 
 	if (ShellExecuteExA(&execInfo) && execInfo.hProcess != 0)
 	{
-		std::cout << "Running Client Hotreload Recompile script...\n";
-		WaitForSingleObject(execInfo.hProcess, INFINITE);
-		std::cout << "Done.\n";
+		std::cout << "Running Client Hotreload Recompile script in the background...\n";
+		Win32HotreloadContext.CompileProcess = execInfo.hProcess;
+		QueryPerformanceCounter(&Win32HotreloadContext.CompileStartTimestamp);
+	}
+	else
+	{
+		std::cerr << "ERROR: Failed to run Client Hotreload Recompile script. Error Code = " << GetLastError() << "\n";
 	}
 #endif
 }
 
-bool Win32_TryHotreloadClientModule(SynergyClientAPI& API, bool bForce)
+void Win32_UpdateHotreloadCompile(SynergyClientAPI& API, bool bHotreload)
+{
+	if (Win32HotreloadContext.CompileProcess == NULL
+		|| WaitForSingleObject(Win32HotreloadContext.CompileProcess, 0) != WAIT_OBJECT_0)
+	{
+		return;
+	}
+
+	// Compile is done. Report how it went.
+	LARGE_INTEGER compileEndTimestamp, performanceFrequency;
+	QueryPerformanceCounter(&compileEndTimestamp);
+	QueryPerformanceFrequency(&performanceFrequency);
+	double compileSeconds = (double)(compileEndTimestamp.QuadPart - Win32HotreloadContext.CompileStartTimestamp.QuadPart) / performanceFrequency.QuadPart;
+
+	DWORD exitCode = 1;
+	GetExitCodeProcess(Win32HotreloadContext.CompileProcess, &exitCode);
+	CloseHandle(Win32HotreloadContext.CompileProcess);
+	Win32HotreloadContext.CompileProcess = NULL;
+
+	if (exitCode != 0)
+	{
+		std::cerr << "Client Hotreload Recompile script failed after " << compileSeconds << " s (exit code " << exitCode << "). Keeping current client module.\n";
+		return;
+	}
+
+	std::cout << "Client Hotreload Recompile script succeeded in " << compileSeconds << " s.\n";
+
+	// Swap the new module in right away rather than waiting on the watcher.
+	if (bHotreload)
+	{
+		Win32_TryHotreloadClientModule(API, true);
+	}
+}
+
+/*
+	Looks for a complete client library at the source path, filling in its find data if found.
+	Returns false if there is none or if it can't be opened exclusively yet, which means it is still being written or is in use.
+*/
+bool FindHotreloadCandidate(WIN32_FIND_DATAA& OutFindData)
 {
 	// Look for a hotreload candidate file at the source path.
-	WIN32_FIND_DATAA sourceFileFindData;
-	if (FindFirstFileA(CLIENT_MODULE_SOURCE_PATH CLIENT_MODULE_FILENAME_BASE "*.dll", &sourceFileFindData) == INVALID_HANDLE_VALUE)
+	HANDLE findHandle = FindFirstFileA(CLIENT_MODULE_SOURCE_PATH CLIENT_MODULE_FILENAME_BASE "*" CLIENT_LIBRARY_FILE_EXTENSION, &OutFindData);
+	if (findHandle == INVALID_HANDLE_VALUE)
 	{
 		// No valid lib file was found at source path.
 		return false;
 	}
 
-	uint64_t currentTime = *(uint64_t*)(&Win32HotreloadContext.LastLoadedClientLibraryFileWriteTime);
-	uint64_t fileTime = *(uint64_t*)(&sourceFileFindData.ftLastWriteTime);
-
-	// Check that the hotreload is forced or that the file found is more recent than the one currently loaded.
-	if (!bForce 
-		&& (!CompareFileTime(&Win32HotreloadContext.LastLoadedClientLibraryFileWriteTime, &sourceFileFindData.ftLastWriteTime) 
-		|| Win32HotreloadContext.LibFilename.compare(sourceFileFindData.cFileName) == 0))
+	/*
+		Older versions may linger next to the newest one, as a version staged through a hard link can't be deleted from the source folder while
+		it is loaded. Always pick the most recently written one.
+	*/
+	WIN32_FIND_DATAA nextFindData;
+	while (FindNextFileA(findHandle, &nextFindData))
 	{
-		return false;
+		if (CompareFileTime(&nextFindData.ftLastWriteTime, &OutFindData.ftLastWriteTime) > 0)
+		{
+			OutFindData = nextFindData;
+		}
 	}
+	FindClose(findHandle);
 
 	std::string sourceFilePath = CLIENT_MODULE_SOURCE_PATH;
-	sourceFilePath += sourceFileFindData.cFileName;
+	sourceFilePath += OutFindData.cFileName;
 
 	// Check that it is possible to open the file.
 	HANDLE createTestHandle = CreateFileA(sourceFilePath.c_str(), GENERIC_READ, NULL, NULL, OPEN_EXISTING, NULL, NULL);
@@ -298,9 +513,207 @@ bool Win32_TryHotreloadClientModule(SynergyClientAPI& API, bool bForce)
 	}
 	CloseHandle(createTestHandle);
 
+	return true;
+}
+
+bool Win32_TryHotreloadClientModule(SynergyClientAPI& API, bool bForce)
+{
+	WIN32_FIND_DATAA sourceFileFindData;
+	if (!FindHotreloadCandidate(sourceFileFindData))
+	{
+		return false;
+	}
+
+	// Check that the hotreload is forced or that the file found is more recent than the one currently loaded.
+	if (!bForce 
+		&& (!CompareFileTime(&Win32HotreloadContext.LastLoadedClientLibraryFileWriteTime, &sourceFileFindData.ftLastWriteTime) 
+		|| Win32HotreloadContext.LibFilename.compare(sourceFileFindData.cFileName) == 0))
+	{
+		return false;
+	}
+
+	std::string sourceFilePath = CLIENT_MODULE_SOURCE_PATH;
+	sourceFilePath += sourceFileFindData.cFileName;
+
 	// We've found a candidate for hotreload !
 	HotreloadClientModule(API, sourceFilePath);
 
 	return API.APISuccessfullyLoaded();
 }
+
+bool Win32_HotreloadClientModuleIfReady(SynergyClientAPI& API)
+{
+	// Plain load first so frames without any change don't pay for an atomic exchange.
+	if (!Win32HotreloadContext.bNewLibraryReady.load(std::memory_order_acquire)
+		|| !Win32HotreloadContext.bNewLibraryReady.exchange(false, std::memory_order_acq_rel))
+	{
+		return false;
+	}
+
+	return Win32_TryHotreloadClientModule(API);
+}
+
+// Returns whether the passed change notification concerns a client library or symbols file.
+bool IsClientLibraryChangeNotification(const FILE_NOTIFY_INFORMATION& Notification)
+{
+	static const WCHAR CLIENT_MODULE_FILENAME_BASE_WIDE[] = L"" CLIENT_MODULE_FILENAME_BASE;
+	static const size_t BASE_NAME_LENGTH = sizeof(CLIENT_MODULE_FILENAME_BASE_WIDE) / sizeof(WCHAR) - 1;
+
+	// Notification file names are not null terminated.
+	size_t fileNameLength = Notification.FileNameLength / sizeof(WCHAR);
+	return fileNameLength >= BASE_NAME_LENGTH
+		&& _wcsnicmp(Notification.FileName, CLIENT_MODULE_FILENAME_BASE_WIDE, BASE_NAME_LENGTH) == 0;
+}
+
+/*
+	Hotreload watcher thread entry point. Waits on change notifications for the client library source folder, and once changes to client library
+	files have settled for HOTRELOAD_WATCHER_DEBOUNCE_MS and the new library can be opened, signals the main thread through bNewLibraryReady.
+*/
+DWORD WINAPI HotreloadWatcherThreadProc(LPVOID Parameter)
+{
+	HANDLE directory = CreateFileA(CLIENT_MODULE_SOURCE_PATH, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+
+	if (directory == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "WARNING: Failed to watch client source folder \"" << CLIENT_MODULE_SOURCE_PATH << "\" for changes. Error Code = " << GetLastError() 
+			<< "\nNew client library versions will only be loaded on request.\n";
+		return 1;
+	}
+
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+	// Notifications are written as DWORD aligned records.
+	alignas(DWORD) uint8_t notificationBuffer[16 * 1024];
+	const DWORD notificationFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+
+	HANDLE waitHandles[2] = { Win32HotreloadContext.WatcherStopEvent, overlapped.hEvent };
+
+	bool bReadPending = false;
+	bool bChangePending = false;
+	ULONGLONG lastChangeTime = 0;
+
+	while (true)
+	{
+		if (!bReadPending)
+		{
+			if (!ReadDirectoryChangesW(directory, notificationBuffer, sizeof(notificationBuffer), FALSE, notificationFilter, NULL, &overlapped, NULL))
+			{
+				std::cerr << "WARNING: Stopped watching client source folder for changes. Error Code = " << GetLastError() << "\n";
+				break;
+			}
+			bReadPending = true;
+		}
+
+		// Only wake up on a timer while debouncing a change.
+		DWORD timeout = INFINITE;
+		if (bChangePending)
+		{
+			ULONGLONG elapsed = GetTickCount64() - lastChangeTime;
+			timeout = elapsed >= HOTRELOAD_WATCHER_DEBOUNCE_MS ? 0 : (DWORD)(HOTRELOAD_WATCHER_DEBOUNCE_MS - elapsed);
+		}
+
+		DWORD waitResult = WaitForMultipleObjects(2, waitHandles, FALSE, timeout);
+
+		if (waitResult == WAIT_OBJECT_0)
+		{
+			// Stop requested.
+			break;
+		}
+		else if (waitResult == WAIT_OBJECT_0 + 1)
+		{
+			DWORD bytesTransferred = 0;
+			GetOverlappedResult(directory, &overlapped, &bytesTransferred, FALSE);
+			bReadPending = false;
+
+			// Zero bytes means notifications overflowed the buffer, in which case assume the client library changed.
+			bool bClientLibraryChanged = bytesTransferred == 0;
+
+			DWORD notificationOffset = 0;
+			while (!bClientLibraryChanged && notificationOffset < bytesTransferred)
+			{
+				FILE_NOTIFY_INFORMATION& notification = *(FILE_NOTIFY_INFORMATION*)(notificationBuffer + notificationOffset);
+				bClientLibraryChanged = IsClientLibraryChangeNotification(notification);
+
+				if (notification.NextEntryOffset == 0)
+				{
+					break;
+				}
+				notificationOffset += notification.NextEntryOffset;
+			}
+
+			if (bClientLibraryChanged)
+			{
+				bChangePending = true;
+				lastChangeTime = GetTickCount64();
+			}
+		}
+		else if (waitResult == WAIT_TIMEOUT && bChangePending)
+		{
+			// Writes have settled. Signal the main thread only if the library is complete, otherwise keep waiting.
+			WIN32_FIND_DATAA candidateFindData;
+			if (FindHotreloadCandidate(candidateFindData))
+			{
+				Win32HotreloadContext.bNewLibraryReady.store(true, std::memory_order_release);
+				bChangePending = false;
+			}
+			else
+			{
+				lastChangeTime = GetTickCount64();
+			}
+		}
+		else
+		{
+			std::cerr << "WARNING: Stopped watching client source folder for changes. Error Code = " << GetLastError() << "\n";
+			break;
+		}
+	}
+
+	if (bReadPending)
+	{
+		CancelIo(directory);
+
+		DWORD bytesTransferred = 0;
+		GetOverlappedResult(directory, &overlapped, &bytesTransferred, TRUE);
+	}
+
+	CloseHandle(overlapped.hEvent);
+	CloseHandle(directory);
+	return 0;
+}
+
+void Win32_StartHotreloadWatcher()
+{
+	if (Win32HotreloadContext.WatcherThread != NULL)
+	{
+		return;
+	}
+
+	Win32HotreloadContext.WatcherStopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	Win32HotreloadContext.WatcherThread = CreateThread(NULL, 0, HotreloadWatcherThreadProc, NULL, 0, NULL);
+
+	if (Win32HotreloadContext.WatcherThread == NULL)
+	{
+		std::cerr << "WARNING: Failed to start hotreload watcher thread. Error Code = " << GetLastError() << "\n";
+		CloseHandle(Win32HotreloadContext.WatcherStopEvent);
+		Win32HotreloadContext.WatcherStopEvent = NULL;
+	}
+}
+
+void Win32_StopHotreloadWatcher()
+{
+	if (Win32HotreloadContext.WatcherThread == NULL)
+	{
+		return;
+	}
+
+	SetEvent(Win32HotreloadContext.WatcherStopEvent);
+	WaitForSingleObject(Win32HotreloadContext.WatcherThread, INFINITE);
+
+	CloseHandle(Win32HotreloadContext.WatcherThread);
+	CloseHandle(Win32HotreloadContext.WatcherStopEvent);
+	Win32HotreloadContext.WatcherThread = NULL;
+	Win32HotreloadContext.WatcherStopEvent = NULL;
+}
 #endif
\ No newline at end of file
@@ -0,0 +1,391 @@
+SOURCE_INC_FILE()
+
+// Symbol definitions for capturing the draw calls emitted by the client into a trace file, and replaying traces through the rasterizer alone.
+
+#include "SynergyClientAPI.h"
+#include "Platform/Win32_Platform.h"
+
+// Identifies draw call trace files ("SYDT" in little endian) and the version of their layout.
+#define DRAW_CALL_TRACE_MAGIC (0x54445953)
+#define DRAW_CALL_TRACE_VERSION (2)
+
+// Size by which the trace file and its mapping grow whenever the capture runs out of mapped space.
+#define DRAW_CALL_TRACE_GROWTH_SIZE (64ull * 1024 * 1024)
+
+// Header found at the start of every draw call trace file.
+struct Win32DrawCallTraceFileHeader
+{
+	uint32_t Magic = DRAW_CALL_TRACE_MAGIC;
+	uint32_t Version = DRAW_CALL_TRACE_VERSION;
+};
+
+/*
+	Header of the draw calls of a single viewport over a single frame, immediately followed by DataSize bytes of draw call buffer content, then
+	by the ClipCommandCount clip commands the client recorded, in the order it recorded them.
+	Records are padded so that each one starts on an 8 bytes boundary.
+*/
+struct Win32DrawCallTraceRecordHeader
+{
+	uint64_t FrameNumber = 0;
+	uint64_t DataSize = 0;
+	uint32_t ViewportIndex = 0;
+	uint16_t Width = 0;
+	uint16_t Height = 0;
+	uint32_t ClipCommandCount = 0;
+	uint32_t Padding = 0;
+};
+
+// State of the draw call capture. The trace file is mapped in memory and only ever appended to.
+struct Win32DrawCallCaptureContext
+{
+	HANDLE File = INVALID_HANDLE_VALUE;
+	HANDLE Mapping = NULL;
+	uint8_t* MappedView = nullptr;
+
+	// Current size of the file and its mapping, in bytes.
+	uint64_t MappedSize = 0;
+
+	// Offset at which the next record will be written. Is the actual size of the trace.
+	uint64_t WriteOffset = 0;
+};
+
+static Win32DrawCallCaptureContext Win32DrawCallCapture;
+
+// Releases the current mapping of the trace file, if any.
+void UnmapDrawCallTraceFile()
+{
+	if (Win32DrawCallCapture.MappedView != nullptr)
+	{
+		UnmapViewOfFile(Win32DrawCallCapture.MappedView);
+		Win32DrawCallCapture.MappedView = nullptr;
+	}
+
+	if (Win32DrawCallCapture.Mapping != NULL)
+	{
+		CloseHandle(Win32DrawCallCapture.Mapping);
+		Win32DrawCallCapture.Mapping = NULL;
+	}
+}
+
+/*
+	Makes sure at least RequiredSize bytes are available past the write offset in the mapped trace file, growing the file and re-mapping it if needed.
+	Returns whether the space is available.
+*/
+bool ReserveDrawCallTraceSpace(uint64_t RequiredSize)
+{
+	if (Win32DrawCallCapture.MappedView != nullptr && Win32DrawCallCapture.MappedSize - Win32DrawCallCapture.WriteOffset >= RequiredSize)
+	{
+		return true;
+	}
+
+	UnmapDrawCallTraceFile();
+
+	uint64_t newSize = Win32DrawCallCapture.MappedSize + DRAW_CALL_TRACE_GROWTH_SIZE;
+	while (newSize - Win32DrawCallCapture.WriteOffset < RequiredSize)
+	{
+		newSize += DRAW_CALL_TRACE_GROWTH_SIZE;
+	}
+
+	// Creating a mapping larger than the file extends the file.
+	Win32DrawCallCapture.Mapping = CreateFileMappingA(Win32DrawCallCapture.File, NULL, PAGE_READWRITE, (DWORD)(newSize >> 32), (DWORD)(newSize), NULL);
+	if (Win32DrawCallCapture.Mapping != NULL)
+	{
+		Win32DrawCallCapture.MappedView = (uint8_t*)(MapViewOfFile(Win32DrawCallCapture.Mapping, FILE_MAP_WRITE, 0, 0, 0));
+	}
+
+	if (Win32DrawCallCapture.MappedView == nullptr)
+	{
+		std::cerr << "ERROR: Failed to map draw call trace file to " << newSize << " bytes. Error Code = " << GetLastError() << "\n";
+		UnmapDrawCallTraceFile();
+		return false;
+	}
+
+	Win32DrawCallCapture.MappedSize = newSize;
+	return true;
+}
+
+bool Win32_BeginDrawCallCapture(const std::string& FilePath)
+{
+	Win32_EndDrawCallCapture();
+
+	Win32DrawCallCapture.File = CreateFileA(FilePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (Win32DrawCallCapture.File == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "ERROR: Failed to create draw call trace file \"" << FilePath << "\". Error Code = " << GetLastError() << "\n";
+		return false;
+	}
+
+	if (!ReserveDrawCallTraceSpace(sizeof(Win32DrawCallTraceFileHeader)))
+	{
+		Win32_EndDrawCallCapture();
+		return false;
+	}
+
+	Win32DrawCallTraceFileHeader fileHeader = {};
+	memcpy(Win32DrawCallCapture.MappedView, &fileHeader, sizeof(fileHeader));
+	Win32DrawCallCapture.WriteOffset = sizeof(fileHeader);
+
+	std::cout << "Capturing draw calls to \"" << FilePath << "\".\n";
+	return true;
+}
+
+void Win32_CaptureDrawCalls(uint64_t FrameNumber, uint32_t ViewportIndex, uint16_t Width, uint16_t Height, const Win32DrawCallBuffer& DrawCallBuffer)
+{
+	if (Win32DrawCallCapture.File == INVALID_HANDLE_VALUE || DrawCallBuffer.Buffer == nullptr)
+	{
+		return;
+	}
+
+	Win32DrawCallTraceRecordHeader recordHeader = {};
+	recordHeader.FrameNumber = FrameNumber;
+	recordHeader.DataSize = DrawCallBuffer.CursorPosition;
+	recordHeader.ViewportIndex = ViewportIndex;
+	recordHeader.Width = Width;
+	recordHeader.Height = Height;
+	recordHeader.ClipCommandCount = DrawCallBuffer.ClipCommandCount;
+
+	uint64_t clipCommandsSize = (uint64_t)(recordHeader.ClipCommandCount) * sizeof(Win32ClipCommand);
+	uint64_t recordSize = (sizeof(recordHeader) + recordHeader.DataSize + clipCommandsSize + 7) & ~7ull;
+	if (!ReserveDrawCallTraceSpace(recordSize))
+	{
+		std::cerr << "ERROR: Out of space in draw call trace. Ending capture.\n";
+		Win32_EndDrawCallCapture();
+		return;
+	}
+
+	uint8_t* record = Win32DrawCallCapture.MappedView + Win32DrawCallCapture.WriteOffset;
+	memcpy(record, &recordHeader, sizeof(recordHeader));
+	memcpy(record + sizeof(recordHeader), DrawCallBuffer.Buffer, recordHeader.DataSize);
+
+	// The buffer holds clip commands backwards from its end. Store them in order.
+	uint8_t* clipCommands = record + sizeof(recordHeader) + recordHeader.DataSize;
+	for (uint32_t commandIndex = 0; commandIndex < recordHeader.ClipCommandCount; commandIndex++)
+	{
+		memcpy(clipCommands + commandIndex * sizeof(Win32ClipCommand), &DrawCallBuffer.GetClipCommand(commandIndex), sizeof(Win32ClipCommand));
+	}
+
+	Win32DrawCallCapture.WriteOffset += recordSize;
+}
+
+void Win32_EndDrawCallCapture()
+{
+	UnmapDrawCallTraceFile();
+
+	if (Win32DrawCallCapture.File != INVALID_HANDLE_VALUE)
+	{
+		// Trim the file down to the data that was actually written.
+		LARGE_INTEGER traceSize;
+		traceSize.QuadPart = Win32DrawCallCapture.WriteOffset;
+		SetFilePointerEx(Win32DrawCallCapture.File, traceSize, NULL, FILE_BEGIN);
+		SetEndOfFile(Win32DrawCallCapture.File);
+
+		CloseHandle(Win32DrawCallCapture.File);
+	}
+
+	Win32DrawCallCapture = {};
+}
+
+// Returns the 64 bits FNV-1a hash of the visible pixels of the passed surface. Row padding is left out.
+uint64_t ComputePixelSurfaceChecksum(const Win32PixelSurface& Surface)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for (uint16_t y = 0; y < Surface.Height; y++)
+	{
+		const Win32PixelRGBA* row = Surface.Pixels + (size_t)(y) * Surface.Stride;
+		for (uint16_t x = 0; x < Surface.Width; x++)
+		{
+			hash ^= row[x].full;
+			hash *= 0x100000001b3ull;
+		}
+	}
+
+	return hash;
+}
+
+bool Win32_ReplayDrawCallTrace(const std::string& FilePath)
+{
+	// Map the whole trace in memory, read only.
+	HANDLE file = CreateFileA(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "ERROR: Failed to open draw call trace \"" << FilePath << "\". Error Code = " << GetLastError() << "\n";
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	GetFileSizeEx(file, &fileSize);
+
+	HANDLE mapping = fileSize.QuadPart > 0 ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	const uint8_t* trace = mapping != NULL ? (const uint8_t*)(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+
+	Win32DrawCallTraceFileHeader expectedHeader = {};
+	Win32DrawCallTraceFileHeader fileHeader = {};
+	if (trace != nullptr && (uint64_t)(fileSize.QuadPart) >= sizeof(fileHeader))
+	{
+		memcpy(&fileHeader, trace, sizeof(fileHeader));
+	}
+
+	if (fileHeader.Magic != expectedHeader.Magic || fileHeader.Version != expectedHeader.Version)
+	{
+		std::cerr << "ERROR: \"" << FilePath << "\" is not a draw call trace compatible with this build.\n";
+		if (trace != nullptr) UnmapViewOfFile(trace);
+		if (mapping != NULL) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	std::cout << "Replaying draw call trace \"" << FilePath << "\".\n";
+
+	LARGE_INTEGER performanceFrequency;
+	QueryPerformanceFrequency(&performanceFrequency);
+
+	/*
+		Rasterizing modifies draw calls in place, so each record gets copied into a scratch draw call buffer before being read.
+		Scratch buffer is reused across records and only grows. The pixel surface gets resized the same way viewport surfaces are.
+	*/
+	Win32DrawCallBuffer scratchDrawCallBuffer = {};
+	Win32PixelSurface surface = {};
+
+	uint64_t traceSize = fileSize.QuadPart;
+	uint64_t readOffset = sizeof(fileHeader);
+
+	uint64_t replayedFrameCount = 0;
+	uint64_t currentFrameNumber = 0;
+	int64_t currentFrameTicks = 0;
+	int64_t totalTicks = 0;
+	uint64_t currentFrameChecksum = 0;
+	uint64_t traceChecksum = 0;
+	bool bFrameInProgress = false;
+
+	while (true)
+	{
+		// Records are padded to 8 bytes, so skipping the padding of a truncated trace's last record can move past its end.
+		Win32DrawCallTraceRecordHeader recordHeader;
+		bool bRecordAvailable = readOffset <= traceSize && traceSize - readOffset >= sizeof(recordHeader);
+		if (readOffset > traceSize)
+		{
+			std::cerr << "ERROR: Draw call trace is truncated at frame " << currentFrameNumber << ".\n";
+		}
+
+		if (bRecordAvailable)
+		{
+			memcpy(&recordHeader, trace + readOffset, sizeof(recordHeader));
+			uint64_t remainingSize = traceSize - readOffset - sizeof(recordHeader);
+			if (remainingSize < recordHeader.DataSize
+				|| remainingSize - recordHeader.DataSize < (uint64_t)(recordHeader.ClipCommandCount) * sizeof(Win32ClipCommand))
+			{
+				std::cerr << "ERROR: Draw call trace is truncated at frame " << recordHeader.FrameNumber << ".\n";
+				bRecordAvailable = false;
+			}
+		}
+
+		// Report the previous frame once all of its viewports have been replayed.
+		if (bFrameInProgress && (!bRecordAvailable || recordHeader.FrameNumber != currentFrameNumber))
+		{
+			std::cout << "Frame " << currentFrameNumber << ": " << currentFrameTicks * 1000.0 / performanceFrequency.QuadPart << " ms, checksum "
+				<< std::hex << currentFrameChecksum << std::dec << "\n";
+
+			totalTicks += currentFrameTicks;
+			traceChecksum = (traceChecksum ^ currentFrameChecksum) * 0x100000001b3ull;
+			replayedFrameCount++;
+			bFrameInProgress = false;
+		}
+
+		if (!bRecordAvailable)
+		{
+			break;
+		}
+
+		if (!bFrameInProgress)
+		{
+			currentFrameNumber = recordHeader.FrameNumber;
+			currentFrameTicks = 0;
+			currentFrameChecksum = 0xcbf29ce484222325ull;
+			bFrameInProgress = true;
+		}
+
+		// Prepare scratch buffers.
+		size_t requiredPixelCount = (size_t)(recordHeader.Width) * recordHeader.Height;
+		if (requiredPixelCount > 0)
+		{
+			Win32_ResizePixelSurface(surface, recordHeader.Width, recordHeader.Height);
+		}
+
+		// Clip commands go at the end of the scratch buffer, where draw call buffers keep them.
+		uint64_t clipCommandsSize = (uint64_t)(recordHeader.ClipCommandCount) * sizeof(Win32ClipCommand);
+		uint64_t requiredBufferSize = recordHeader.DataSize + clipCommandsSize;
+		if (requiredBufferSize > scratchDrawCallBuffer.BufferSize)
+		{
+			free(scratchDrawCallBuffer.Buffer);
+			scratchDrawCallBuffer.Buffer = (uint8_t*)(malloc(requiredBufferSize));
+			scratchDrawCallBuffer.BufferSize = scratchDrawCallBuffer.Buffer != nullptr ? requiredBufferSize : 0;
+		}
+
+		if ((requiredPixelCount > 0 && surface.Pixels == nullptr) || (requiredBufferSize > 0 && scratchDrawCallBuffer.Buffer == nullptr))
+		{
+			std::cerr << "ERROR: Failed to allocate replay buffers for frame " << recordHeader.FrameNumber << ". Ending replay.\n";
+			break;
+		}
+
+		// Clear any leftover from a larger previous record so the buffer end gets detected, then copy the record's draw calls and clip commands in.
+		if (scratchDrawCallBuffer.Buffer != nullptr)
+		{
+			scratchDrawCallBuffer.BeginWrite();
+			memcpy(scratchDrawCallBuffer.Buffer, trace + readOffset + sizeof(recordHeader), recordHeader.DataSize);
+
+			const uint8_t* clipCommands = trace + readOffset + sizeof(recordHeader) + recordHeader.DataSize;
+			Win32ClipCommand* bufferEnd = (Win32ClipCommand*)(scratchDrawCallBuffer.Buffer + scratchDrawCallBuffer.BufferSize);
+			for (uint32_t commandIndex = 0; commandIndex < recordHeader.ClipCommandCount; commandIndex++)
+			{
+				memcpy(bufferEnd - commandIndex - 1, clipCommands + commandIndex * sizeof(Win32ClipCommand), sizeof(Win32ClipCommand));
+			}
+			scratchDrawCallBuffer.ClipCommandCount = recordHeader.ClipCommandCount;
+		}
+
+		// Rasterize and time the record, the same way the main loop does.
+		LARGE_INTEGER rasterStart, rasterEnd;
+		QueryPerformanceCounter(&rasterStart);
+
+		if (requiredPixelCount > 0)
+		{
+			Win32_ClearPixelSurface(0xFF000000, surface);
+
+			// Clip commands get replayed in step with the draw calls, the same way the main loop does.
+			if (recordHeader.DataSize > 0 && scratchDrawCallBuffer.BeginRead())
+			{
+				Win32ClipTracker clipTracker;
+				clipTracker.Begin(scratchDrawCallBuffer, surface);
+
+				DrawCall* nextDrawCall = nullptr;
+				while ((nextDrawCall = scratchDrawCallBuffer.GetNext()) != nullptr)
+				{
+					Win32_ProcessDrawCall(*nextDrawCall, surface, clipTracker.GetClip(nextDrawCall));
+				}
+			}
+		}
+
+		QueryPerformanceCounter(&rasterEnd);
+		currentFrameTicks += rasterEnd.QuadPart - rasterStart.QuadPart;
+
+		if (requiredPixelCount > 0)
+		{
+			currentFrameChecksum = (currentFrameChecksum ^ ComputePixelSurfaceChecksum(surface)) * 0x100000001b3ull;
+		}
+
+		readOffset += (sizeof(recordHeader) + recordHeader.DataSize + clipCommandsSize + 7) & ~7ull;
+	}
+
+	double totalMilliseconds = totalTicks * 1000.0 / performanceFrequency.QuadPart;
+	std::cout << "Draw call trace replay done: " << replayedFrameCount << " frames rasterized in " << totalMilliseconds << " ms ("
+		<< (replayedFrameCount > 0 ? totalMilliseconds / replayedFrameCount : 0.0) << " ms per frame), trace checksum "
+		<< std::hex << traceChecksum << std::dec << "\n";
+
+	Win32_ReleasePixelSurface(surface);
+	free(scratchDrawCallBuffer.Buffer);
+
+	UnmapViewOfFile(trace);
+	CloseHandle(mapping);
+	CloseHandle(file);
+	return true;
+}
\ No newline at end of file
@@ -5,6 +5,8 @@ SOURCE_INC_FILE()
 #include "SynergyClientAPI.h"
 #include "Platform/Win32_Platform.h"
 
+#include <vector>
+
 bool Win32DrawCallBuffer::BeginWrite()
 {
 	/* 
@@ -24,6 +26,10 @@ bool Win32DrawCallBuffer::BeginWrite()
 	}
 
 	CursorPosition = 0;
+	RejectedDrawCallCount = 0;
+	CulledDrawCallCount = 0;
+	ClipCommandCount = 0;
+	ClipDepth = 0;
 	memset(Buffer, 0, BufferSize);
 	return true;
 }
@@ -31,11 +37,13 @@ bool Win32DrawCallBuffer::BeginWrite()
 DrawCall* Win32DrawCallBuffer::NewDrawCall(DrawCallType Type)
 {
 	size_t requiredSize = GetDrawCallSize(Type);
+	size_t drawCallLimit = GetDrawCallLimit();
 
-	if (requiredSize > BufferSize - CursorPosition)
+	if (requiredSize > drawCallLimit - CursorPosition)
 	{
 		std::cerr << "ERROR: Out of memory in draw call buffer. Attempted to create draw call of type " << (uint16_t)(Type)
-			<< " with only " << BufferSize - CursorPosition << " bytes available.\n";
+			<< " with only " << drawCallLimit - CursorPosition << " bytes available.\n";
+		RejectedDrawCallCount++;
 		return nullptr;
 	}
 
@@ -47,6 +55,132 @@ DrawCall* Win32DrawCallBuffer::NewDrawCall(DrawCallType Type)
 	return address;
 }
 
+void Win32DrawCallBuffer::EndWrite()
+{
+	CullDrawCalls();
+}
+
+bool Win32DrawCallBuffer::PushClip(const Win32ClipRect& Rect)
+{
+	if (Buffer == nullptr || ClipDepth >= WIN32_CLIP_STACK_CAPACITY || GetDrawCallLimit() - CursorPosition < sizeof(Win32ClipCommand))
+	{
+		return false;
+	}
+
+	Win32ClipRect clipRect = ClipDepth > 0 ? Win32_IntersectClipRects(Rect, ClipStack[ClipDepth - 1]) : Rect;
+	ClipStack[ClipDepth++] = clipRect;
+
+	// Commands are laid out backwards from the end of the buffer.
+	ClipCommandCount++;
+	Win32ClipCommand& command = ((Win32ClipCommand*)(Buffer + BufferSize))[-(int64_t)(ClipCommandCount)];
+	command.DrawCallPosition = (uint32_t)(CursorPosition);
+	command.bPop = false;
+	command.Rect = clipRect;
+	return true;
+}
+
+bool Win32DrawCallBuffer::PopClip()
+{
+	if (Buffer == nullptr || ClipDepth == 0 || GetDrawCallLimit() - CursorPosition < sizeof(Win32ClipCommand))
+	{
+		return false;
+	}
+
+	ClipDepth--;
+
+	ClipCommandCount++;
+	Win32ClipCommand& command = ((Win32ClipCommand*)(Buffer + BufferSize))[-(int64_t)(ClipCommandCount)];
+	command.DrawCallPosition = (uint32_t)(CursorPosition);
+	command.bPop = true;
+	command.Rect = {};
+	return true;
+}
+
+size_t Win32DrawCallBuffer::GetDrawCallLimit() const
+{
+	return BufferSize - ClipCommandCount * sizeof(Win32ClipCommand);
+}
+
+const Win32ClipCommand& Win32DrawCallBuffer::GetClipCommand(uint32_t CommandIndex) const
+{
+	return ((const Win32ClipCommand*)(Buffer + BufferSize))[-(int64_t)(CommandIndex) - 1];
+}
+
+void Win32DrawCallBuffer::CullDrawCalls()
+{
+	// Calls get culled against the viewport and the clip rectangle they were made with, whichever are set.
+	bool bViewportCulling = CullWidth > 0 && CullHeight > 0;
+	if (Buffer == nullptr || (!bViewportCulling && ClipCommandCount == 0))
+	{
+		return;
+	}
+
+	// Cull rectangles, the bottom one being the viewport and the one of the current clip rectangle on top.
+	Win32ClipRect viewportRect = { 0, 0, CullWidth, CullHeight };
+	Win32ClipRect cullStack[WIN32_CLIP_STACK_CAPACITY + 1];
+	cullStack[0] = viewportRect;
+	uint32_t cullDepth = 0;
+	uint32_t commandIndex = 0;
+
+	// Slide kept calls down over culled ones. Clip commands follow the call they were recorded before.
+	size_t readPosition = 0;
+	size_t writePosition = 0;
+	while (readPosition < CursorPosition)
+	{
+		for (; commandIndex < ClipCommandCount && GetClipCommand(commandIndex).DrawCallPosition <= readPosition; commandIndex++)
+		{
+			Win32ClipCommand& command = ((Win32ClipCommand*)(Buffer + BufferSize))[-(int64_t)(commandIndex) - 1];
+			command.DrawCallPosition = (uint32_t)(writePosition);
+
+			if (command.bPop && cullDepth > 0)
+			{
+				cullDepth--;
+			}
+			else if (!command.bPop && cullDepth < WIN32_CLIP_STACK_CAPACITY)
+			{
+				cullDepth++;
+				cullStack[cullDepth] = bViewportCulling ? Win32_IntersectClipRects(command.Rect, viewportRect) : command.Rect;
+			}
+		}
+
+		DrawCall* call = (DrawCall*)(Buffer + readPosition);
+		size_t callSize = GetDrawCallSize(call->type);
+		if (callSize == 0 || callSize > CursorPosition - readPosition)
+		{
+			// Calls that can't be walked past, which a valid buffer never holds. Keep the rest of the buffer as is.
+			break;
+		}
+
+		if ((bViewportCulling || cullDepth > 0) && Win32_IsDrawCallOutsideClip(*call, cullStack[cullDepth]))
+		{
+			CulledDrawCallCount++;
+		}
+		else
+		{
+			if (writePosition != readPosition)
+			{
+				memmove(Buffer + writePosition, Buffer + readPosition, callSize);
+			}
+			writePosition += callSize;
+		}
+
+		readPosition += callSize;
+	}
+
+	// Move whatever couldn't be walked, and clip commands recorded past the last call, down by the room culled calls gave back.
+	size_t culledSize = readPosition - writePosition;
+	memmove(Buffer + writePosition, Buffer + readPosition, CursorPosition - readPosition);
+	for (; commandIndex < ClipCommandCount; commandIndex++)
+	{
+		Win32ClipCommand& command = ((Win32ClipCommand*)(Buffer + BufferSize))[-(int64_t)(commandIndex) - 1];
+		command.DrawCallPosition -= (uint32_t)(min((size_t)(command.DrawCallPosition), culledSize));
+	}
+
+	// Zero out the room given back, so that the buffer still ends on an empty call.
+	CursorPosition -= culledSize;
+	memset(Buffer + CursorPosition, 0, culledSize);
+}
+
 bool Win32DrawCallBuffer::BeginRead()
 {
 	// Reset Cursor Position to 0. Run safety checks on the buffer and check that the first draw call's type is a valid value.
@@ -80,8 +214,9 @@ DrawCall* Win32DrawCallBuffer::GetNext()
 		Then, return the DrawCall structure.
 	*/
 
+	size_t drawCallLimit = GetDrawCallLimit();
 	DrawCall* nextCall = (DrawCall*)(Buffer + CursorPosition);
-	if (CursorPosition == BufferSize || nextCall->type == DrawCallType::EMPTY)
+	if (CursorPosition >= drawCallLimit || nextCall->type == DrawCallType::EMPTY)
 	{
 		// End of buffer reached.
 		return nullptr;
@@ -96,11 +231,11 @@ DrawCall* Win32DrawCallBuffer::GetNext()
 		return nullptr;
 	}
 
-	if (BufferSize - CursorPosition < actualDrawCallSize)
+	if (drawCallLimit - CursorPosition < actualDrawCallSize)
 	{
 		// There isn't enough data left to hold the last draw call given the type it's supposed to be, which means the buffer was inconsistently populated.
 		std::cerr << "ERROR: Inconsistent draw call buffer size. Check that is was populated correctly. Read draw call of type " << (uint16_t)(nextCall->type)
-			<< " with only " << BufferSize - CursorPosition << " bytes available.\n";
+			<< " with only " << drawCallLimit - CursorPosition << " bytes available.\n";
 		return nullptr;
 	}
 
@@ -112,128 +247,350 @@ DrawCall* Win32DrawCallBuffer::GetNext()
 	return nextCall;
 }
 
-void Win32_ClearPixelBuffer(Win32PixelRGBA PixelColor, Win32PixelBuffer& PixelBuffer, uint16_t BufferWidth, uint16_t BufferHeight)
+void Win32ClipTracker::Begin(const Win32DrawCallBuffer& DrawCallBuffer, const Win32PixelSurface& Surface, float ScaleX, float ScaleY)
 {
-	memset(PixelBuffer, PixelColor.full, BufferWidth * BufferHeight * sizeof(Win32PixelRGBA));
+	Buffer = &DrawCallBuffer;
+	this->ScaleX = ScaleX;
+	this->ScaleY = ScaleY;
+	Stack[0] = Win32_GetSurfaceClipRect(Surface);
+	Depth = 0;
+	NextCommandIndex = 0;
 }
 
-void DrawLine(LineDrawCallData& LineDrawCall, Win32PixelBuffer& PixelBuffer, uint16_t BufferWidth, uint16_t BufferHeight)
+const Win32ClipRect& Win32ClipTracker::GetClip(const DrawCall* Call)
 {
-	Vector2f lineVec;
-	lineVec = (LineDrawCall.destination - LineDrawCall.origin);
-
-	// Track iteration count separately as it needs to stay a positive, relative number in all cases.
-	int it = -1;
-
-	if (abs(lineVec.x) > abs(lineVec.y))
+	// Apply every clip command recorded before the call.
+	size_t callPosition = (const uint8_t*)(Call) - Buffer->Buffer;
+	for (; NextCommandIndex < Buffer->ClipCommandCount; NextCommandIndex++)
 	{
-		float yIncrement = lineVec.y / abs(lineVec.x);
-		for (int x = LineDrawCall.origin.x;; lineVec.x > 0 ? x++ : x--)
+		const Win32ClipCommand& command = Buffer->GetClipCommand(NextCommandIndex);
+		if (command.DrawCallPosition > callPosition)
 		{
-			it++;
-			if (x < 0)
-			{
-				if (lineVec.x > 0)
-					continue;
-				else
-					break;
-			}
-			else if (x >= BufferWidth)
-			{
-				if (lineVec.x < 0)
-					continue;
-				else
-					break;
-			}
+			break;
+		}
 
-			// Compute final coordinates of pixel to be colored.
-			uint16_t finalY = (uint16_t)(LineDrawCall.origin.y + yIncrement * it);
-			if (finalY < 0 || finalY >= BufferHeight)
+		if (command.bPop)
+		{
+			if (Depth > 0)
 			{
-				continue;
+				Depth--;
 			}
+		}
+		else if (Depth < WIN32_CLIP_STACK_CAPACITY)
+		{
+			// Round outwards when scaling, so that scaled draw calls along the clip edges don't lose pixels.
+			Win32ClipRect scaledRect;
+			scaledRect.MinX = (int32_t)(floorf(command.Rect.MinX * ScaleX));
+			scaledRect.MinY = (int32_t)(floorf(command.Rect.MinY * ScaleY));
+			scaledRect.MaxX = (int32_t)(ceilf(command.Rect.MaxX * ScaleX));
+			scaledRect.MaxY = (int32_t)(ceilf(command.Rect.MaxY * ScaleY));
+
+			// Intersecting with the current rectangle keeps rounding from leaking outside of it, and limits the bottom one to the surface.
+			Stack[Depth + 1] = Win32_IntersectClipRects(scaledRect, Stack[Depth]);
+			Depth++;
+		}
+	}
+
+	return Stack[Depth];
+}
 
-			PixelBuffer[finalY * BufferWidth + x].full = LineDrawCall.color.full;
+// Unused pixel surfaces, kept around so that resizing back and forth doesn't re-allocate.
+static std::vector<Win32PixelSurface> Win32PixelSurfacePool;
 
-			if (x == LineDrawCall.destination.x)
-			{
-				break;
-			}
-		}
+// Guards the pool, shared by every thread running client sessions.
+static SRWLOCK Win32PixelSurfacePoolLock = SRWLOCK_INIT;
+
+// Rounds a pixel dimension up to its size class.
+uint32_t GetPixelSurfaceSizeClass(uint16_t Dimension)
+{
+	uint32_t sizeClass = ((uint32_t)(Dimension) + WIN32_PIXEL_SURFACE_SIZE_CLASS - 1) / WIN32_PIXEL_SURFACE_SIZE_CLASS * WIN32_PIXEL_SURFACE_SIZE_CLASS;
+	return max(sizeClass, (uint32_t)(WIN32_PIXEL_SURFACE_SIZE_CLASS));
+}
+
+// Frees the bitmap and Device Context of a surface.
+void FreePixelSurface(Win32PixelSurface& Surface)
+{
+	// The DC goes first so that the bitmap isn't selected into anything anymore when deleted.
+	if (Surface.BitmapDC != NULL)
+	{
+		DeleteDC(Surface.BitmapDC);
 	}
-	else
+
+	if (Surface.Bitmap != NULL)
 	{
-		float xIncrement = lineVec.x / abs(lineVec.y);
-		for (int y = LineDrawCall.origin.y;; lineVec.y > 0 ? y++ : y--)
-		{
-			it++;
-			if (y < 0)
-			{
-				if (lineVec.y > 0)
-					continue;
-				else
-					break;
-			}
-			else if (y >= BufferHeight)
-			{
-				if (lineVec.y < 0)
-					continue;
-				else
-					break;
-			}
+		DeleteObject(Surface.Bitmap);
+	}
 
-			// Compute final coordinates of pixel to be colored.
-			uint16_t finalX = (uint16_t)(LineDrawCall.origin.x + xIncrement * it);
-			if (finalX < 0 || finalX >= BufferHeight)
-			{
-				continue;
-			}
-			PixelBuffer[y * BufferWidth + finalX].full = LineDrawCall.color.full;
+	Surface = {};
+}
 
-			if (y == LineDrawCall.destination.y)
-			{
-				break;
-			}
+/*
+	Creates a surface of exactly Stride x CapacityHeight pixels. Pixel memory is allocated by the system unless a file mapping Section is passed,
+	in which case pixels are placed in it at SectionOffset.
+*/
+bool AllocatePixelSurface(Win32PixelSurface& Surface, uint32_t Stride, uint32_t CapacityHeight, HANDLE Section = NULL, DWORD SectionOffset = 0)
+{
+	Surface = {};
+
+	// Init bitmap info for 32 bits RGBA format pixels.
+	BITMAPINFO bitmapInfo = {};
+	bitmapInfo.bmiHeader.biSize = sizeof(bitmapInfo.bmiHeader);
+	bitmapInfo.bmiHeader.biWidth = Stride;
+	bitmapInfo.bmiHeader.biHeight = -(LONG)(CapacityHeight); // Let's stick to upper-left origin.
+	bitmapInfo.bmiHeader.biPlanes = 1;
+	bitmapInfo.bmiHeader.biBitCount = 32;
+	bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+	// Create Device-Independent Bitmap section. Its memory is page aligned, and with Stride being aligned so is every row.
+	Surface.Bitmap = CreateDIBSection(NULL, &bitmapInfo, DIB_RGB_COLORS, (void**)(&Surface.Pixels), Section, SectionOffset);
+	if (Surface.Bitmap == NULL || Surface.Pixels == nullptr)
+	{
+		std::cerr << "ERROR: Failed to allocate bitmap of size " << Stride << " x " << CapacityHeight << " !\n";
+		FreePixelSurface(Surface);
+		return false;
+	}
+
+	// Create a memory DC holding the bitmap, to be used to copy the bitmap memory onto windows.
+	Surface.BitmapDC = CreateCompatibleDC(NULL);
+	if (Surface.BitmapDC == NULL)
+	{
+		std::cerr << "ERROR: Failed to create Device Context for bitmap of size " << Stride << " x " << CapacityHeight << " !\n";
+		FreePixelSurface(Surface);
+		return false;
+	}
+	SelectObject(Surface.BitmapDC, Surface.Bitmap);
+
+	Surface.Stride = Stride;
+	Surface.CapacityHeight = CapacityHeight;
+	return true;
+}
+
+bool Win32_ResizePixelSurface(Win32PixelSurface& Surface, uint16_t Width, uint16_t Height)
+{
+	uint32_t requiredStride = GetPixelSurfaceSizeClass(Width);
+	uint32_t requiredHeight = GetPixelSurfaceSizeClass(Height);
+
+	// Keep the current allocation if it is the right size class.
+	if (Surface.Pixels != nullptr && !Surface.bOnSection && Surface.Stride == requiredStride && Surface.CapacityHeight == requiredHeight)
+	{
+		Surface.Width = Width;
+		Surface.Height = Height;
+		return true;
+	}
+
+	Win32_ReleasePixelSurface(Surface);
+
+	// Take the smallest pooled surface that fits without wasting more than a size class in either dimension.
+	AcquireSRWLockExclusive(&Win32PixelSurfacePoolLock);
+	size_t bestPoolIndex = Win32PixelSurfacePool.size();
+	for (size_t poolIndex = 0; poolIndex < Win32PixelSurfacePool.size(); poolIndex++)
+	{
+		const Win32PixelSurface& pooledSurface = Win32PixelSurfacePool[poolIndex];
+		if (pooledSurface.Stride < requiredStride || pooledSurface.Stride > requiredStride + WIN32_PIXEL_SURFACE_SIZE_CLASS
+			|| pooledSurface.CapacityHeight < requiredHeight || pooledSurface.CapacityHeight > requiredHeight + WIN32_PIXEL_SURFACE_SIZE_CLASS)
+		{
+			continue;
 		}
+
+		if (bestPoolIndex == Win32PixelSurfacePool.size()
+			|| (uint64_t)(pooledSurface.Stride) * pooledSurface.CapacityHeight
+				< (uint64_t)(Win32PixelSurfacePool[bestPoolIndex].Stride) * Win32PixelSurfacePool[bestPoolIndex].CapacityHeight)
+		{
+			bestPoolIndex = poolIndex;
+		}
+	}
+
+	bool bTakenFromPool = bestPoolIndex < Win32PixelSurfacePool.size();
+	if (bTakenFromPool)
+	{
+		Surface = Win32PixelSurfacePool[bestPoolIndex];
+		Win32PixelSurfacePool.erase(Win32PixelSurfacePool.begin() + bestPoolIndex);
+	}
+	ReleaseSRWLockExclusive(&Win32PixelSurfacePoolLock);
+
+	if (!bTakenFromPool && !AllocatePixelSurface(Surface, requiredStride, requiredHeight))
+	{
+		return false;
 	}
+
+	Surface.Width = Width;
+	Surface.Height = Height;
+	return true;
 }
 
-void DrawRectangle(RectangleDrawCallData& RectDrawCall, Win32PixelBuffer& PixelBuffer, uint16_t BufferWidth, uint16_t BufferHeight)
+bool Win32_CreatePixelSurfaceOnSection(Win32PixelSurface& Surface, uint16_t Width, uint16_t Height, HANDLE Section, DWORD SectionOffset)
 {
-	Vector2s minCoord, maxCoord;
+	Win32_ReleasePixelSurface(Surface);
 
-	// Min coordinates, INCLUSIVE
-	minCoord.x = max(0, RectDrawCall.origin.x);
-	minCoord.y = max(0, RectDrawCall.origin.y);
+	// No size classes here: the section is sized by the caller, so only row alignment matters.
+	uint32_t stride = ((uint32_t)(Width) + WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT - 1) / WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT * WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT;
+	stride = max(stride, (uint32_t)(WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT));
 
-	if (minCoord.x >= BufferWidth || minCoord.y >= BufferHeight)
+	if (!AllocatePixelSurface(Surface, stride, max((uint32_t)(Height), 1u), Section, SectionOffset))
 	{
-		// Rectangle is entirely outside screen. Ignore draw call.
-		return;
+		return false;
 	}
 
-	// Max coordinates, EXCLUSIVE
-	maxCoord.x = min(BufferWidth, RectDrawCall.origin.x + RectDrawCall.dimensions.x);
-	maxCoord.y = min(BufferHeight, RectDrawCall.origin.y + RectDrawCall.dimensions.y);
+	Surface.Width = Width;
+	Surface.Height = Height;
+	Surface.bOnSection = true;
+	return true;
+}
+
+void Win32_ReleasePixelSurface(Win32PixelSurface& Surface)
+{
+	if (Surface.Pixels == nullptr)
+	{
+		Surface = {};
+		return;
+	}
 
-	if (maxCoord.x < 0 || maxCoord.y < 0)
+	// Surfaces placed in a caller's section can't be reused for anything else.
+	if (Surface.bOnSection)
 	{
-		// Rectangle is entirely outside screen. Ignore draw call.
+		FreePixelSurface(Surface);
 		return;
 	}
 
+	// Make room by evicting the oldest pooled surface if the pool is full. It gets freed outside of the lock.
+	Win32PixelSurface evictedSurface = {};
+
+	AcquireSRWLockExclusive(&Win32PixelSurfacePoolLock);
+	if (Win32PixelSurfacePool.size() >= WIN32_PIXEL_SURFACE_POOL_CAPACITY)
+	{
+		evictedSurface = Win32PixelSurfacePool.front();
+		Win32PixelSurfacePool.erase(Win32PixelSurfacePool.begin());
+	}
+
+	Win32PixelSurfacePool.push_back(Surface);
+	ReleaseSRWLockExclusive(&Win32PixelSurfacePoolLock);
+
+	Surface = {};
+	if (evictedSurface.Pixels != nullptr)
+	{
+		FreePixelSurface(evictedSurface);
+	}
+}
+
+void Win32_FreePixelSurfacePool()
+{
+	AcquireSRWLockExclusive(&Win32PixelSurfacePoolLock);
+	for (Win32PixelSurface& pooledSurface : Win32PixelSurfacePool)
+	{
+		FreePixelSurface(pooledSurface);
+	}
+	Win32PixelSurfacePool.clear();
+	ReleaseSRWLockExclusive(&Win32PixelSurfacePoolLock);
+}
+
+void Win32_ClearPixelSurface(Win32PixelRGBA PixelColor, Win32PixelSurface& Surface)
+{
+	// Rows are contiguous, padding included, so the visible rows get filled in one go. Pixels are 32 bits wide so memset can't be used.
+	Win32PixelRGBA* pixel = Surface.Pixels;
+	Win32PixelRGBA* end = Surface.Pixels + (size_t)(Surface.Stride) * Surface.Height;
+	for (; pixel < end; pixel++)
+	{
+		pixel->full = PixelColor.full;
+	}
+}
+
+Win32ClipRect Win32_GetSurfaceClipRect(const Win32PixelSurface& Surface)
+{
+	return Win32ClipRect{ 0, 0, Surface.Width, Surface.Height };
+}
+
+Win32ClipRect Win32_IntersectClipRects(const Win32ClipRect& A, const Win32ClipRect& B)
+{
+	return Win32ClipRect{ max(A.MinX, B.MinX), max(A.MinY, B.MinY), min(A.MaxX, B.MaxX), min(A.MaxY, B.MaxY) };
+}
+
+/*
+	Draw call kernels only write pixels within the clip rectangle, which they narrow the range they walk down to first, and return the count of
+	pixels they wrote.
+*/
+
+uint64_t DrawLine(LineDrawCallData& LineDrawCall, Win32PixelSurface& Surface, const Win32ClipRect& Clip)
+{
+	Vector2f lineVec;
+	lineVec = (LineDrawCall.destination - LineDrawCall.origin);
+
+	// Lines are walked one pixel at a time along their major axis, the other coordinate being interpolated.
+	bool bXMajor = abs(lineVec.x) > abs(lineVec.y);
+	int32_t majorOrigin = bXMajor ? LineDrawCall.origin.x : LineDrawCall.origin.y;
+	int32_t majorDestination = bXMajor ? LineDrawCall.destination.x : LineDrawCall.destination.y;
+	float minorOrigin = bXMajor ? LineDrawCall.origin.y : LineDrawCall.origin.x;
+	float majorLength = abs(bXMajor ? lineVec.x : lineVec.y);
+	float minorIncrement = majorLength > 0 ? (bXMajor ? lineVec.y : lineVec.x) / majorLength : 0.f;
+
+	int32_t clipMajorMin = bXMajor ? Clip.MinX : Clip.MinY;
+	int32_t clipMajorMax = bXMajor ? Clip.MaxX : Clip.MaxY;
+	int32_t clipMinorMin = bXMajor ? Clip.MinY : Clip.MinX;
+	int32_t clipMinorMax = bXMajor ? Clip.MaxY : Clip.MaxX;
+
+	// Only walk the part of the major axis range that lies within the clip rectangle.
+	int32_t step = majorDestination >= majorOrigin ? 1 : -1;
+	int32_t first = step > 0 ? max(majorOrigin, clipMajorMin) : min(majorOrigin, clipMajorMax - 1);
+	int32_t last = step > 0 ? min(majorDestination, clipMajorMax - 1) : max(majorDestination, clipMajorMin);
+	if ((last - first) * step < 0)
+	{
+		// Line is entirely outside the clip rectangle. Ignore draw call.
+		return 0;
+	}
+
+	uint64_t pixelsWritten = 0;
+	for (int32_t major = first;; major += step)
+	{
+		// Track iteration count separately as it needs to stay a positive, relative number in all cases.
+		int32_t it = (major - majorOrigin) * step;
+		int32_t minor = (int32_t)(minorOrigin + minorIncrement * it);
+
+		if (minor >= clipMinorMin && minor < clipMinorMax)
+		{
+			int32_t x = bXMajor ? major : minor;
+			int32_t y = bXMajor ? minor : major;
+			Surface.Pixels[y * Surface.Stride + x].full = LineDrawCall.color.full;
+			pixelsWritten++;
+		}
+
+		if (major == last)
+		{
+			break;
+		}
+	}
+
+	return pixelsWritten;
+}
+
+uint64_t DrawRectangle(RectangleDrawCallData& RectDrawCall, Win32PixelSurface& Surface, const Win32ClipRect& Clip)
+{
+	// Min coordinates INCLUSIVE, max coordinates EXCLUSIVE, limited to the clip rectangle.
+	int32_t minX = max(Clip.MinX, (int32_t)(RectDrawCall.origin.x));
+	int32_t minY = max(Clip.MinY, (int32_t)(RectDrawCall.origin.y));
+	int32_t maxX = min(Clip.MaxX, (int32_t)(RectDrawCall.origin.x) + RectDrawCall.dimensions.x);
+	int32_t maxY = min(Clip.MaxY, (int32_t)(RectDrawCall.origin.y) + RectDrawCall.dimensions.y);
+
+	if (minX >= maxX || minY >= maxY)
+	{
+		// Rectangle is entirely outside the clip rectangle. Ignore draw call.
+		return 0;
+	}
+
 	// Pixels are stored line by line in memory. Set the memory line by line accordingly.
-	for (uint16_t y = minCoord.y; y < maxCoord.y; y++)
+	for (int32_t y = minY; y < maxY; y++)
 	{
-		for (uint16_t x = minCoord.x; x < maxCoord.x; x++)
+		for (int32_t x = minX; x < maxX; x++)
 		{
-			PixelBuffer[y * BufferWidth + x].full = RectDrawCall.color.full;
+			Surface.Pixels[y * Surface.Stride + x].full = RectDrawCall.color.full;
 		}
 	}
+
+	return (uint64_t)(maxX - minX) * (maxY - minY);
 }
 
-void DrawEllipse(EllipseDrawCallData& EllipseDrawCall, Win32PixelBuffer& PixelBuffer, uint16_t BufferWidth, uint16_t BufferHeight)
+uint64_t DrawEllipse(EllipseDrawCallData& EllipseDrawCall, Win32PixelSurface& Surface, const Win32ClipRect& Clip)
 {
+	uint64_t pixelsWritten = 0;
+
 	// Pre process circle calls into a ellipse call with Y = X.
 	if (EllipseDrawCall.ellipticRadii.y <= 0)
 	{
@@ -277,19 +634,103 @@ void DrawEllipse(EllipseDrawCallData& EllipseDrawCall, Win32PixelBuffer& PixelBu
 		}
 		lastDrawnLine = leftPoint.y;
 
-		// Draw line from left to right point.
-		for (uint16_t x = leftPoint.x; x < rightPoint.x; x++)
+		// Draw line from left to right point, limited to the clip rectangle.
+		if (leftPoint.y < Clip.MinY || leftPoint.y >= Clip.MaxY)
 		{
-			if (x < 0) continue;
-			if (x >= BufferWidth
-				|| leftPoint.y < 0 || leftPoint.y >= BufferHeight) break;
+			continue;
+		}
 
-			PixelBuffer[leftPoint.y * BufferWidth + x].full = EllipseDrawCall.color.full;
+		int32_t spanStart = max((int32_t)(leftPoint.x), Clip.MinX);
+		int32_t spanEnd = min((int32_t)(rightPoint.x), Clip.MaxX);
+		for (int32_t x = spanStart; x < spanEnd; x++)
+		{
+			Surface.Pixels[leftPoint.y * Surface.Stride + x].full = EllipseDrawCall.color.full;
+		}
+		pixelsWritten += spanEnd > spanStart ? spanEnd - spanStart : 0;
+	}
+
+	return pixelsWritten;
+}
+
+// Scales both components of a draw call vector, whatever their type.
+template<typename VectorType>
+void ScaleDrawCallVector(VectorType& Vector, float ScaleX, float ScaleY)
+{
+	Vector.x = (decltype(Vector.x))(Vector.x * ScaleX);
+	Vector.y = (decltype(Vector.y))(Vector.y * ScaleY);
+}
+
+void Win32_ScaleDrawCall(DrawCall& Call, float ScaleX, float ScaleY)
+{
+	LineDrawCallData& line = (LineDrawCallData&)(Call);
+	RectangleDrawCallData& rect = (RectangleDrawCallData&)(Call);
+	EllipseDrawCallData& ellipse = (EllipseDrawCallData&)(Call);
+	switch (Call.type)
+	{
+	case(DrawCallType::LINE):
+		ScaleDrawCallVector(line.origin, ScaleX, ScaleY);
+		ScaleDrawCallVector(line.destination, ScaleX, ScaleY);
+		break;
+	case(DrawCallType::RECTANGLE):
+		ScaleDrawCallVector(rect.origin, ScaleX, ScaleY);
+		ScaleDrawCallVector(rect.dimensions, ScaleX, ScaleY);
+		break;
+	case(DrawCallType::ELLIPSE):
+		// Circles only specify their X radius, which needs to be scaled along Y too.
+		if (ellipse.ellipticRadii.y <= 0)
+		{
+			ellipse.ellipticRadii.y = ellipse.ellipticRadii.x;
 		}
+		ScaleDrawCallVector(ellipse.origin, ScaleX, ScaleY);
+		ScaleDrawCallVector(ellipse.ellipticRadii, ScaleX, ScaleY);
+		break;
+	default:
+		break;
 	}
 }
 
-void Win32_ProcessDrawCall(DrawCall& Call, Win32PixelBuffer& PixelBuffer, uint16_t BufferWidth, uint16_t BufferHeight)
+bool Win32_IsDrawCallOutsideClip(const DrawCall& Call, const Win32ClipRect& Clip)
+{
+	const LineDrawCallData& line = (const LineDrawCallData&)(Call);
+	const RectangleDrawCallData& rect = (const RectangleDrawCallData&)(Call);
+	const EllipseDrawCallData& ellipse = (const EllipseDrawCallData&)(Call);
+
+	// Bounding box, INCLUSIVE on both ends.
+	int32_t minX, minY, maxX, maxY;
+	switch (Call.type)
+	{
+	case(DrawCallType::LINE):
+		minX = min((int32_t)(line.origin.x), (int32_t)(line.destination.x));
+		minY = min((int32_t)(line.origin.y), (int32_t)(line.destination.y));
+		maxX = max((int32_t)(line.origin.x), (int32_t)(line.destination.x));
+		maxY = max((int32_t)(line.origin.y), (int32_t)(line.destination.y));
+		break;
+	case(DrawCallType::RECTANGLE):
+		minX = rect.origin.x;
+		minY = rect.origin.y;
+		maxX = (int32_t)(rect.origin.x) + rect.dimensions.x - 1;
+		maxY = (int32_t)(rect.origin.y) + rect.dimensions.y - 1;
+		break;
+	case(DrawCallType::ELLIPSE):
+	{
+		// Elliptic radii span the whole ellipse, centered on its origin (see DrawEllipse()). Circles only specify their X radius.
+		int32_t radiusX = ellipse.ellipticRadii.x;
+		int32_t radiusY = ellipse.ellipticRadii.y <= 0 ? radiusX : (int32_t)(ellipse.ellipticRadii.y);
+		minX = ellipse.origin.x - radiusX / 2 - 1;
+		minY = ellipse.origin.y - radiusY / 2 - 1;
+		maxX = ellipse.origin.x + radiusX / 2 + 1;
+		maxY = ellipse.origin.y + radiusY / 2 + 1;
+		break;
+	}
+	default:
+		// Unknown calls are left for rasterization to deal with.
+		return false;
+	}
+
+	return maxX < Clip.MinX || maxY < Clip.MinY || minX >= Clip.MaxX || minY >= Clip.MaxY;
+}
+
+uint64_t Win32_ProcessDrawCall(DrawCall& Call, Win32PixelSurface& Surface, const Win32ClipRect& Clip)
 {
 	// Pre process draw call, changing its color format to be little-endian-friendly (otherwise Red and Blue will be inverted).
 	// This is necessary because color is written directly using the 32 bits member of the union, triggering an accidental
@@ -304,16 +745,13 @@ void Win32_ProcessDrawCall(DrawCall& Call, Win32PixelBuffer& PixelBuffer, uint16
 	switch (Call.type)
 	{
 	case(DrawCallType::LINE):
-		DrawLine(line, PixelBuffer, BufferWidth, BufferHeight);
-		break;
+		return DrawLine(line, Surface, Clip);
 	case(DrawCallType::RECTANGLE):
-		DrawRectangle(rect, PixelBuffer, BufferWidth, BufferHeight);
-		break;
+		return DrawRectangle(rect, Surface, Clip);
 	case(DrawCallType::ELLIPSE):
-		DrawEllipse(ellipse, PixelBuffer, BufferWidth, BufferHeight);
-		break;
+		return DrawEllipse(ellipse, Surface, Clip);
 	default:
 		std::cerr << "WARNING: Unsupported Client Draw Call type " << (uint16_t)(Call.type) << " ! Ignoring...\n";
-		break;
+		return 0;
 	}
 }
\ No newline at end of file
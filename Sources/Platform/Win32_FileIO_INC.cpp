@@ -0,0 +1,394 @@
+SOURCE_INC_FILE()
+
+/*
+	Symbol definitions for the file services offered to the client (see SynergyPlatformFileAPI.h).
+	Asynchronous reads are queued to a small pool of worker threads through an I/O completion port and read in chunks straight into client memory,
+	their status being published through a fixed table of request slots the client polls.
+*/
+
+#include "SynergyPlatformFileAPI.h"
+#include "Platform/Win32_Platform.h"
+
+// Lifecycle of a request slot. Only the thread that moved a slot to a state may move it out of it, except for PENDING which the worker ends.
+enum class Win32FileRequestState : uint32_t
+{
+	FREE,
+	CLAIMED,	// Being filled in by the thread making the request.
+	PENDING,	// Queued or being read by a worker.
+	COMPLETE,
+	FAILED
+};
+
+// Set along with a slot's state once cancellation of its request was asked for. Only workers of PENDING requests look at it.
+#define WIN32_FILE_REQUEST_CANCEL_BIT (1ull << 31)
+
+struct Win32FileRequest
+{
+	/*
+		The slot's state in the low 32 bits, along with WIN32_FILE_REQUEST_CANCEL_BIT, and its generation in the high ones. The generation is
+		incremented each time the slot gets claimed, so that IDs of requests that got polled or cancelled don't match the slot's next request.
+		Both live in one atomic so that moving a slot out of a state also checks it still holds the request an ID was given for.
+	*/
+	std::atomic<uint64_t> StateAndGeneration{ 0 };
+
+	char Path[MAX_PATH] = {};
+	uint64_t Offset = 0;
+	uint64_t Size = 0;
+	uint8_t* Destination = nullptr;
+
+	uint64_t BytesRead = 0;
+};
+
+// Request IDs hold the slot index in their low bits and the slot's generation above it.
+#define WIN32_FILE_REQUEST_SLOT_BITS (8)
+static_assert(WIN32_FILE_IO_MAX_REQUESTS <= (1 << WIN32_FILE_REQUEST_SLOT_BITS), "File request slot indices must fit in request IDs.");
+
+struct Win32FileIOContext
+{
+	// Completion port workers wait on. Each queued request gets posted to it with its slot index + 1 as key, 0 asking a worker to exit.
+	HANDLE Port = NULL;
+
+	HANDLE Workers[WIN32_FILE_IO_WORKER_COUNT] = {};
+
+	Win32FileRequest Requests[WIN32_FILE_IO_MAX_REQUESTS];
+};
+
+static Win32FileIOContext Win32FileIO;
+
+uint64_t MakeFileRequestStateAndGeneration(Win32FileRequestState State, uint32_t Generation)
+{
+	return ((uint64_t)(Generation) << 32) | (uint64_t)(State);
+}
+
+Win32FileRequestState GetFileRequestState(uint64_t StateAndGeneration)
+{
+	return (Win32FileRequestState)(StateAndGeneration & (UINT32_MAX & ~WIN32_FILE_REQUEST_CANCEL_BIT));
+}
+
+uint32_t GetFileRequestGeneration(uint64_t StateAndGeneration)
+{
+	return (uint32_t)(StateAndGeneration >> 32);
+}
+
+// Reads the request's range into its destination. Returns whether the file could be opened and read without error or cancellation.
+bool ReadFileRequest(Win32FileRequest& Request)
+{
+	HANDLE file = CreateFileA(Request.Path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "ERROR: Could not open file \"" << Request.Path << "\" for reading. Error Code = " << GetLastError() << "\n";
+		return false;
+	}
+
+	LARGE_INTEGER offset;
+	offset.QuadPart = (LONGLONG)(Request.Offset);
+	bool bSuccess = SetFilePointerEx(file, offset, NULL, FILE_BEGIN) != 0;
+
+	// Read in chunks so cancellation is noticed quickly even when reading large files.
+	while (bSuccess && Request.BytesRead < Request.Size)
+	{
+		if ((Request.StateAndGeneration.load(std::memory_order_relaxed) & WIN32_FILE_REQUEST_CANCEL_BIT) != 0)
+		{
+			bSuccess = false;
+			break;
+		}
+
+		DWORD chunkSize = (DWORD)(min(Request.Size - Request.BytesRead, (uint64_t)(WIN32_FILE_IO_CHUNK_SIZE)));
+		DWORD chunkBytesRead = 0;
+		if (!ReadFile(file, Request.Destination + Request.BytesRead, chunkSize, &chunkBytesRead, NULL))
+		{
+			std::cerr << "ERROR: Failed to read file \"" << Request.Path << "\". Error Code = " << GetLastError() << "\n";
+			bSuccess = false;
+			break;
+		}
+
+		// End of file.
+		if (chunkBytesRead == 0)
+		{
+			break;
+		}
+		Request.BytesRead += chunkBytesRead;
+	}
+
+	CloseHandle(file);
+	return bSuccess;
+}
+
+DWORD WINAPI FileIOWorkerThreadProc(LPVOID Parameter)
+{
+	while (true)
+	{
+		DWORD bytesTransferred = 0;
+		ULONG_PTR completionKey = 0;
+		LPOVERLAPPED overlapped = nullptr;
+		if (!GetQueuedCompletionStatus(Win32FileIO.Port, &bytesTransferred, &completionKey, &overlapped, INFINITE) || completionKey == 0)
+		{
+			return 0;
+		}
+
+		// Requests cancelled while queued don't even get opened.
+		Win32FileRequest& request = Win32FileIO.Requests[completionKey - 1];
+		uint64_t stateAndGeneration = request.StateAndGeneration.load(std::memory_order_acquire);
+		bool bSuccess = (stateAndGeneration & WIN32_FILE_REQUEST_CANCEL_BIT) == 0 && ReadFileRequest(request);
+
+		// Nobody else moves the slot out of PENDING, so its generation is still the one loaded above.
+		Win32FileRequestState state = bSuccess ? Win32FileRequestState::COMPLETE : Win32FileRequestState::FAILED;
+		request.StateAndGeneration.store(MakeFileRequestStateAndGeneration(state, GetFileRequestGeneration(stateAndGeneration)), std::memory_order_release);
+	}
+}
+
+/*
+	Returns the slot of the passed request ID if it still refers to the request it was given for, nullptr otherwise. The slot's state and
+	generation as they were checked are written to OutStateAndGeneration, for callers to compare-exchange against.
+*/
+Win32FileRequest* FindFileRequest(PlatformFileRequestID RequestID, uint64_t& OutStateAndGeneration)
+{
+	uint32_t slotIndex = RequestID & ((1 << WIN32_FILE_REQUEST_SLOT_BITS) - 1);
+	if (RequestID == PLATFORM_FILE_REQUEST_INVALID_ID || slotIndex >= WIN32_FILE_IO_MAX_REQUESTS)
+	{
+		return nullptr;
+	}
+
+	Win32FileRequest& request = Win32FileIO.Requests[slotIndex];
+	uint64_t stateAndGeneration = request.StateAndGeneration.load(std::memory_order_acquire);
+	Win32FileRequestState state = GetFileRequestState(stateAndGeneration);
+	if (state == Win32FileRequestState::FREE || state == Win32FileRequestState::CLAIMED
+		|| GetFileRequestGeneration(stateAndGeneration) != RequestID >> WIN32_FILE_REQUEST_SLOT_BITS)
+	{
+		return nullptr;
+	}
+
+	OutStateAndGeneration = stateAndGeneration;
+	return &request;
+}
+
+PlatformFileRequestID ReadFileAsync(const char* Path, uint64_t Offset, uint64_t Size, void* Destination)
+{
+	if (Win32FileIO.Port == NULL || Path == nullptr || (Destination == nullptr && Size > 0) || strlen(Path) >= MAX_PATH)
+	{
+		return PLATFORM_FILE_REQUEST_INVALID_ID;
+	}
+
+	// Claim the first free slot, moving it to its next generation at the same time.
+	for (uint32_t slotIndex = 0; slotIndex < WIN32_FILE_IO_MAX_REQUESTS; slotIndex++)
+	{
+		Win32FileRequest& request = Win32FileIO.Requests[slotIndex];
+		uint64_t stateAndGeneration = request.StateAndGeneration.load(std::memory_order_relaxed);
+		if (GetFileRequestState(stateAndGeneration) != Win32FileRequestState::FREE)
+		{
+			continue;
+		}
+
+		// Generations wrap around within the bits left in request IDs, skipping 0 so that no ID is ever 0.
+		uint32_t generation = (GetFileRequestGeneration(stateAndGeneration) + 1) & (UINT32_MAX >> WIN32_FILE_REQUEST_SLOT_BITS);
+		if (generation == 0)
+		{
+			generation = 1;
+		}
+
+		uint64_t claimedStateAndGeneration = MakeFileRequestStateAndGeneration(Win32FileRequestState::CLAIMED, generation);
+		if (!request.StateAndGeneration.compare_exchange_strong(stateAndGeneration, claimedStateAndGeneration, std::memory_order_acquire))
+		{
+			continue;
+		}
+
+		strcpy_s(request.Path, Path);
+		request.Offset = Offset;
+		request.Size = Size;
+		request.Destination = (uint8_t*)(Destination);
+		request.BytesRead = 0;
+		request.StateAndGeneration.store(MakeFileRequestStateAndGeneration(Win32FileRequestState::PENDING, generation), std::memory_order_release);
+
+		if (!PostQueuedCompletionStatus(Win32FileIO.Port, 0, (ULONG_PTR)(slotIndex) + 1, NULL))
+		{
+			std::cerr << "ERROR: Failed to queue file request. Error Code = " << GetLastError() << "\n";
+			request.StateAndGeneration.store(MakeFileRequestStateAndGeneration(Win32FileRequestState::FREE, generation), std::memory_order_release);
+			return PLATFORM_FILE_REQUEST_INVALID_ID;
+		}
+
+		return (generation << WIN32_FILE_REQUEST_SLOT_BITS) | slotIndex;
+	}
+
+	std::cerr << "ERROR: Too many pending file requests. Could not queue reading \"" << Path << "\".\n";
+	return PLATFORM_FILE_REQUEST_INVALID_ID;
+}
+
+PlatformFileRequestStatus PollFileRequest(PlatformFileRequestID RequestID, uint64_t& OutBytesRead)
+{
+	uint64_t stateAndGeneration = 0;
+	Win32FileRequest* request = FindFileRequest(RequestID, stateAndGeneration);
+	if (request == nullptr)
+	{
+		return PlatformFileRequestStatus::INVALID;
+	}
+
+	Win32FileRequestState state = GetFileRequestState(stateAndGeneration);
+	if (state == Win32FileRequestState::PENDING)
+	{
+		return PlatformFileRequestStatus::PENDING;
+	}
+
+	// Done. Free the slot, unless another thread polling the same request beat us to it, whether or not the slot got claimed again since.
+	uint64_t bytesRead = request->BytesRead;
+	uint64_t freeStateAndGeneration = MakeFileRequestStateAndGeneration(Win32FileRequestState::FREE, GetFileRequestGeneration(stateAndGeneration));
+	if (!request->StateAndGeneration.compare_exchange_strong(stateAndGeneration, freeStateAndGeneration, std::memory_order_acq_rel))
+	{
+		return PlatformFileRequestStatus::INVALID;
+	}
+
+	OutBytesRead = bytesRead;
+	return state == Win32FileRequestState::COMPLETE ? PlatformFileRequestStatus::COMPLETE : PlatformFileRequestStatus::FAILED;
+}
+
+void CancelFileRequest(PlatformFileRequestID RequestID)
+{
+	uint64_t stateAndGeneration = 0;
+	Win32FileRequest* request = FindFileRequest(RequestID, stateAndGeneration);
+	if (request == nullptr)
+	{
+		return;
+	}
+
+	/*
+		Flag the request and wait for its worker to be done with it. Workers check for cancellation between chunks, so this never waits for
+		long. Comparing generations stops this as soon as the slot got freed by another thread and claimed for another request.
+	*/
+	uint32_t generation = GetFileRequestGeneration(stateAndGeneration);
+	while (GetFileRequestState(stateAndGeneration) == Win32FileRequestState::PENDING && GetFileRequestGeneration(stateAndGeneration) == generation)
+	{
+		if ((stateAndGeneration & WIN32_FILE_REQUEST_CANCEL_BIT) == 0)
+		{
+			request->StateAndGeneration.compare_exchange_strong(stateAndGeneration, stateAndGeneration | WIN32_FILE_REQUEST_CANCEL_BIT, std::memory_order_relaxed);
+		}
+		else
+		{
+			SwitchToThread();
+		}
+		stateAndGeneration = request->StateAndGeneration.load(std::memory_order_acquire);
+	}
+
+	Win32FileRequestState state = GetFileRequestState(stateAndGeneration);
+	if ((state == Win32FileRequestState::COMPLETE || state == Win32FileRequestState::FAILED) && GetFileRequestGeneration(stateAndGeneration) == generation)
+	{
+		uint64_t freeStateAndGeneration = MakeFileRequestStateAndGeneration(Win32FileRequestState::FREE, generation);
+		request->StateAndGeneration.compare_exchange_strong(stateAndGeneration, freeStateAndGeneration, std::memory_order_acq_rel);
+	}
+}
+
+bool QueryFileSize(const char* Path, uint64_t& OutSize)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (Path == nullptr || !GetFileAttributesExA(Path, GetFileExInfoStandard, &attributes))
+	{
+		return false;
+	}
+
+	OutSize = ((uint64_t)(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+	return true;
+}
+
+const void* Win32_MapFile(const char* Path, uint64_t& OutSize)
+{
+	OutSize = 0;
+
+	HANDLE file = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "ERROR: Could not open file \"" << Path << "\" for mapping. Error Code = " << GetLastError() << "\n";
+		return nullptr;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	GetFileSizeEx(file, &fileSize);
+
+	// The view keeps the file mapped on its own, so both handles can go right away.
+	HANDLE mapping = fileSize.QuadPart > 0 ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	const void* memory = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+	if (mapping != NULL)
+	{
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+
+	if (memory == nullptr)
+	{
+		std::cerr << "ERROR: Could not map file \"" << Path << "\". Error Code = " << GetLastError() << "\n";
+		return nullptr;
+	}
+
+	OutSize = (uint64_t)(fileSize.QuadPart);
+	return memory;
+}
+
+void Win32_UnmapFile(const void* Memory)
+{
+	if (Memory != nullptr)
+	{
+		UnmapViewOfFile(Memory);
+	}
+}
+
+bool Win32_StartFileIO()
+{
+	Win32FileIO.Port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, WIN32_FILE_IO_WORKER_COUNT);
+	if (Win32FileIO.Port == NULL)
+	{
+		std::cerr << "ERROR: Could not create file I/O completion port. Error Code = " << GetLastError() << "\n";
+		return false;
+	}
+
+	for (HANDLE& worker : Win32FileIO.Workers)
+	{
+		worker = CreateThread(NULL, 0, FileIOWorkerThreadProc, NULL, 0, NULL);
+		if (worker == NULL)
+		{
+			std::cerr << "ERROR: Could not create file I/O worker thread. Error Code = " << GetLastError() << "\n";
+			Win32_StopFileIO();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Win32_StopFileIO()
+{
+	if (Win32FileIO.Port == NULL)
+	{
+		return;
+	}
+
+	// Cancel whatever is pending so that workers are done quickly and leave client memory alone from now on.
+	for (Win32FileRequest& request : Win32FileIO.Requests)
+	{
+		request.StateAndGeneration.fetch_or(WIN32_FILE_REQUEST_CANCEL_BIT, std::memory_order_relaxed);
+	}
+
+	for (HANDLE worker : Win32FileIO.Workers)
+	{
+		if (worker != NULL)
+		{
+			PostQueuedCompletionStatus(Win32FileIO.Port, 0, 0, NULL);
+		}
+	}
+
+	for (HANDLE& worker : Win32FileIO.Workers)
+	{
+		if (worker != NULL)
+		{
+			WaitForSingleObject(worker, INFINITE);
+			CloseHandle(worker);
+			worker = NULL;
+		}
+	}
+
+	CloseHandle(Win32FileIO.Port);
+	Win32FileIO.Port = NULL;
+}
+
+const PlatformFileAPI& Win32_GetPlatformFileAPI()
+{
+	static const PlatformFileAPI fileAPI = { ReadFileAsync, PollFileRequest, CancelFileRequest, QueryFileSize, Win32_MapFile, Win32_UnmapFile };
+	return fileAPI;
+}
\ No newline at end of file
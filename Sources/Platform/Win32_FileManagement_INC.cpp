@@ -3,6 +3,9 @@ SOURCE_INC_FILE()
 // Name of temporary folder where data only relevant to the current program execution is stored. Gets deleted and recreated by any subsequent launches.
 #define WIN32_TEMP_DATA_FOLDER "Temp"
 
+// Suffix appended to the Temp folder name when a launch moves the previous one aside for background deletion.
+#define WIN32_TEMP_DATA_OLD_FOLDER_SUFFIX ".old."
+
 // Symbol definitions for managing hard drive files for the Win32 platform.
 
 bool Win32_CreateTempCopyFile(const std::string& SourcePath, const std::string& DestPath)
@@ -10,33 +13,77 @@ bool Win32_CreateTempCopyFile(const std::string& SourcePath, const std::string&
 	return CopyFileA(SourcePath.c_str(), Win32_ConvertTempPathToRelativePath(DestPath).c_str(), FALSE);
 }
 
-void Win32_DeleteTempFile(const std::string& FilePath)
+bool Win32_StageTempFile(const std::string& SourcePath, const std::string& DestPath, uint64_t& OutBytesCopied)
 {
-	// If provided file is not relative to temp data folder already, convert it.
-	std::string relativePath;
-	if (FilePath.rfind(WIN32_TEMP_DATA_FOLDER, 0) != 0)
+	OutBytesCopied = 0;
+	std::string relativeDestPath = Win32_ConvertTempPathToRelativePath(DestPath);
+
+	// Hard links can't replace an existing file.
+	DeleteFileA(relativeDestPath.c_str());
+
+	// A hard link only costs a directory entry. It fails if the file system doesn't support them or if the Temp folder is on another volume.
+	if (CreateHardLinkA(relativeDestPath.c_str(), SourcePath.c_str(), NULL))
 	{
-		relativePath = Win32_ConvertTempPathToRelativePath(FilePath);
+		return true;
 	}
-	else
+
+	// Fall back to copying.
+	if (!CopyFileA(SourcePath.c_str(), relativeDestPath.c_str(), FALSE))
 	{
-		relativePath = FilePath;
+		return false;
 	}
 
-	WIN32_FIND_DATAA findData;
-	HANDLE file = FindFirstFileA(relativePath.c_str(), &findData);
+	WIN32_FILE_ATTRIBUTE_DATA fileAttributes;
+	if (GetFileAttributesExA(relativeDestPath.c_str(), GetFileExInfoStandard, &fileAttributes))
+	{
+		OutBytesCopied = ((uint64_t)(fileAttributes.nFileSizeHigh) << 32) | fileAttributes.nFileSizeLow;
+	}
+
+	return true;
+}
 
-	if (file == INVALID_HANDLE_VALUE)
+/*
+	Recursively deletes the file or folder at Path. Path is used as a scratch buffer while walking sub folders and is restored before returning.
+	Stops early, leaving the rest for a later run, if bStopRequested gets set.
+*/
+void DeleteFileTree(std::string& Path, const std::atomic<bool>* bStopRequested)
+{
+	DWORD attributes = GetFileAttributesA(Path.c_str());
+	if (attributes == INVALID_FILE_ATTRIBUTES)
 	{
 		return;
 	}
 
-	if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+	// Read only files can't be deleted as is.
+	if (attributes & FILE_ATTRIBUTE_READONLY)
+	{
+		SetFileAttributesA(Path.c_str(), attributes & ~FILE_ATTRIBUTE_READONLY);
+	}
+
+	if (!(attributes & FILE_ATTRIBUTE_DIRECTORY) || (attributes & FILE_ATTRIBUTE_REPARSE_POINT))
+	{
+		// Files and links to folders are deleted without walking their contents.
+		if (attributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			RemoveDirectoryA(Path.c_str());
+		}
+		else
+		{
+			DeleteFileA(Path.c_str());
+		}
+		return;
+	}
+
+	// Delete every file inside this folder with a single search, then delete the folder itself.
+	size_t folderPathLength = Path.size();
+	Path += "\\*";
+
+	WIN32_FIND_DATAA findData;
+	HANDLE search = FindFirstFileExA(Path.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+	Path.resize(folderPathLength);
+
+	if (search != INVALID_HANDLE_VALUE)
 	{
-		// Delete every file inside this folder then delete the folder itself.
-		HANDLE folder = file;
-		std::string subFolderFilePattern = relativePath + "\\*.*";
-		file = FindFirstFileA(subFolderFilePattern.c_str(), &findData);
 		do
 		{
 			// Ignore current and parent directories
@@ -45,29 +92,100 @@ void Win32_DeleteTempFile(const std::string& FilePath)
 				continue;
 			}
 
-			std::string deletedSubFilePath = relativePath.c_str();
-			deletedSubFilePath += '\\';
-			deletedSubFilePath += findData.cFileName;
+			if (bStopRequested != nullptr && bStopRequested->load(std::memory_order_relaxed))
+			{
+				break;
+			}
 
-			Win32_DeleteTempFile(deletedSubFilePath);
+			Path += '\\';
+			Path += findData.cFileName;
+			DeleteFileTree(Path, bStopRequested);
+			Path.resize(folderPathLength);
 
-			// Set the Find Data back to search pattern for the folder.
-			strcpy_s(findData.cFileName, sizeof(findData.cFileName), subFolderFilePattern.c_str());
+		} while (FindNextFileA(search, &findData));
 
-		} while (FindNextFileA(file, &findData));
-		RemoveDirectoryA(relativePath.c_str());
+		FindClose(search);
+	}
+
+	RemoveDirectoryA(Path.c_str());
+}
+
+void Win32_DeleteTempFile(const std::string& FilePath)
+{
+	// If provided file is not relative to temp data folder already, convert it.
+	std::string relativePath;
+	if (FilePath.rfind(WIN32_TEMP_DATA_FOLDER, 0) != 0)
+	{
+		relativePath = Win32_ConvertTempPathToRelativePath(FilePath);
 	}
 	else
 	{
-		// Delete the file.
-		DeleteFileA(relativePath.c_str());
+		relativePath = FilePath;
 	}
+
+	DeleteFileTree(relativePath, nullptr);
+}
+
+// State of the background deletion of Temp folders left over by previous launches.
+struct Win32TempCleanupContext
+{
+	HANDLE Thread = NULL;
+	std::atomic<bool> bStopRequested{ false };
+};
+
+static Win32TempCleanupContext Win32TempCleanup;
+
+/*
+	Temp cleanup thread entry point. Deletes every folder that previous launches moved aside, including ones a previous cleanup didn't get to
+	finish (the program exited or crashed during it).
+*/
+DWORD WINAPI TempCleanupThreadProc(LPVOID Parameter)
+{
+	// Deleting leftovers is never urgent: keep disk and CPU available for the rest of the program.
+	SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+	WIN32_FIND_DATAA findData;
+	HANDLE search = FindFirstFileExA(WIN32_TEMP_DATA_FOLDER WIN32_TEMP_DATA_OLD_FOLDER_SUFFIX "*", FindExInfoBasic, &findData, 
+		FindExSearchLimitToDirectories, NULL, 0);
+
+	if (search == INVALID_HANDLE_VALUE)
+	{
+		return 0;
+	}
+
+	std::string folderPath;
+	do
+	{
+		if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			continue;
+		}
+
+		folderPath = findData.cFileName;
+		DeleteFileTree(folderPath, &Win32TempCleanup.bStopRequested);
+
+	} while (!Win32TempCleanup.bStopRequested.load(std::memory_order_relaxed) && FindNextFileA(search, &findData));
+
+	FindClose(search);
+	return 0;
 }
 
 void Win32_ResetTempDataFolder()
 {
-	Win32_DeleteTempFile("");
-	if (CreateDirectoryA(WIN32_TEMP_DATA_FOLDER, NULL))
+	/*
+		Move the previous Temp folder aside under a unique name so it can be deleted in the background, then start from a fresh folder right away.
+		If it can't be moved (a file in it is still in use), delete what can be deleted now.
+	*/
+	std::string oldFolderPath = WIN32_TEMP_DATA_FOLDER WIN32_TEMP_DATA_OLD_FOLDER_SUFFIX;
+	oldFolderPath += std::to_string(GetCurrentProcessId()) + "." + std::to_string(GetTickCount64());
+
+	if (!MoveFileExA(WIN32_TEMP_DATA_FOLDER, oldFolderPath.c_str(), 0) && GetLastError() != ERROR_FILE_NOT_FOUND)
+	{
+		std::cerr << "WARNING: Failed to move previous Temp folder aside. Error Code = " << GetLastError() << ". Deleting it in place.\n";
+		Win32_DeleteTempFile("");
+	}
+
+	if (CreateDirectoryA(WIN32_TEMP_DATA_FOLDER, NULL) || GetLastError() == ERROR_ALREADY_EXISTS)
 	{
 		std::cout << "Temp folder cleared and re-created at \"" << WIN32_TEMP_DATA_FOLDER << "\"\n";
 	}
@@ -75,6 +193,29 @@ void Win32_ResetTempDataFolder()
 	{
 		std::cerr << "Failed to create temporary data folder at \"" << WIN32_TEMP_DATA_FOLDER << "\" !\n";
 	}
+
+	Win32TempCleanup.bStopRequested = false;
+	Win32TempCleanup.Thread = CreateThread(NULL, 0, TempCleanupThreadProc, NULL, 0, NULL);
+
+	if (Win32TempCleanup.Thread == NULL)
+	{
+		std::cerr << "WARNING: Failed to start Temp cleanup thread. Error Code = " << GetLastError() 
+			<< ". Previous Temp folders will be deleted by a later launch.\n";
+	}
+}
+
+void Win32_StopTempDataFolderCleanup()
+{
+	if (Win32TempCleanup.Thread == NULL)
+	{
+		return;
+	}
+
+	Win32TempCleanup.bStopRequested = true;
+	WaitForSingleObject(Win32TempCleanup.Thread, INFINITE);
+
+	CloseHandle(Win32TempCleanup.Thread);
+	Win32TempCleanup.Thread = NULL;
 }
 
 std::string Win32_ConvertTempPathToRelativePath(const std::string& TempPath)
@@ -0,0 +1,371 @@
+SOURCE_INC_FILE()
+
+// Symbol definitions for capturing rendered frames to disk, with the copying done on the main thread and the encoding and writing on a writer thread.
+
+#include "Platform/Win32_Platform.h"
+
+#include <vector>
+
+// Identifies frame capture files ("SYFC" in little endian) and the version of their layout.
+#define FRAME_CAPTURE_MAGIC (0x43465953)
+#define FRAME_CAPTURE_VERSION (2)
+
+// Number of frame buffers cycling between the main thread and the writer thread. Frames get dropped when the writer falls this far behind.
+#define FRAME_CAPTURE_BUFFER_COUNT (4)
+
+// Header found at the start of every frame capture file.
+struct Win32FrameCaptureFileHeader
+{
+	uint32_t Magic = FRAME_CAPTURE_MAGIC;
+	uint32_t Version = FRAME_CAPTURE_VERSION;
+};
+
+// Frame record flags.
+#define FRAME_CAPTURE_FLAG_KEYFRAME (1 << 0)
+
+// Set in the pixel count of literal runs. Pixel counts are stored in the remaining bits.
+#define FRAME_CAPTURE_LITERAL_RUN_BIT (0x80000000u)
+#define FRAME_CAPTURE_MAX_RUN_LENGTH (0x7FFFFFFFu)
+
+// Shortest repeat run written. Shorter ones take as much room or more than the same values in a literal run.
+#define FRAME_CAPTURE_MIN_REPEAT_RUN_LENGTH (3)
+
+/*
+	Header of a single viewport's frame, immediately followed by RunCount runs of 32 bits values. Each run starts with a pixel count. Repeat runs
+	follow it with the value repeated over that many pixels, literal runs (FRAME_CAPTURE_LITERAL_RUN_BIT set) with one value per pixel, so that
+	frames that barely compress never take much more room than their raw pixels.
+	Values are XORed with the pixels of the viewport's previous frame, unless the record is a keyframe (first frame of the viewport or a size
+	change) in which case they are the pixels themselves.
+*/
+struct Win32FrameCaptureRecordHeader
+{
+	uint64_t FrameNumber = 0;
+	uint32_t ViewportIndex = 0;
+	uint16_t Width = 0;
+	uint16_t Height = 0;
+	uint32_t Flags = 0;
+	uint32_t RunCount = 0;
+};
+
+// Copy of the visible pixels of a surface, waiting to be written.
+struct Win32CapturedFrame
+{
+	uint32_t* Pixels = nullptr;
+	size_t PixelCapacity = 0;
+
+	uint64_t FrameNumber = 0;
+	uint32_t ViewportIndex = 0;
+	uint16_t Width = 0;
+	uint16_t Height = 0;
+};
+
+// Last frame written for a viewport, which the next one of the same viewport gets delta encoded against.
+struct Win32CapturedViewportHistory
+{
+	std::vector<uint32_t> Pixels;
+	uint16_t Width = 0;
+	uint16_t Height = 0;
+};
+
+/*
+	State of the frame capture. A fixed set of frame buffers cycles between the free list (owned by the main thread once taken) and the pending
+	queue (consumed by the writer thread), which bounds memory use and queue depth. Lists are protected by Lock.
+*/
+struct Win32FrameCaptureContext
+{
+	HANDLE File = INVALID_HANDLE_VALUE;
+	HANDLE WriterThread = NULL;
+
+	SRWLOCK Lock = SRWLOCK_INIT;
+	CONDITION_VARIABLE PendingFramesAvailable = CONDITION_VARIABLE_INIT;
+
+	Win32CapturedFrame Frames[FRAME_CAPTURE_BUFFER_COUNT];
+	std::vector<Win32CapturedFrame*> FreeFrames;
+	std::vector<Win32CapturedFrame*> PendingFrames;
+	bool bStopRequested = false;
+
+	// Writer thread only.
+	std::vector<Win32CapturedViewportHistory> ViewportHistories;
+	std::vector<uint32_t> EncodedRuns;
+
+	// Statistics. Captured and dropped counts and copy times are main thread only, written sizes writer thread only.
+	uint64_t CapturedFrameCount = 0;
+	uint64_t DroppedFrameCount = 0;
+	int64_t TotalCopyTicks = 0;
+	int64_t MaxCopyTicks = 0;
+	uint64_t RawBytes = 0;
+	uint64_t WrittenBytes = 0;
+	bool bWriteFailed = false;
+};
+
+static Win32FrameCaptureContext Win32FrameCapture;
+
+// Writer thread only. Encodes a captured frame against the previous frame of its viewport and appends it to the capture file.
+void WriteCapturedFrame(const Win32CapturedFrame& Frame)
+{
+	if (Frame.ViewportIndex >= Win32FrameCapture.ViewportHistories.size())
+	{
+		Win32FrameCapture.ViewportHistories.resize(Frame.ViewportIndex + 1);
+	}
+
+	Win32CapturedViewportHistory& history = Win32FrameCapture.ViewportHistories[Frame.ViewportIndex];
+	size_t pixelCount = (size_t)(Frame.Width) * Frame.Height;
+
+	Win32FrameCaptureRecordHeader recordHeader = {};
+	recordHeader.FrameNumber = Frame.FrameNumber;
+	recordHeader.ViewportIndex = Frame.ViewportIndex;
+	recordHeader.Width = Frame.Width;
+	recordHeader.Height = Frame.Height;
+
+	bool bKeyframe = history.Width != Frame.Width || history.Height != Frame.Height;
+	if (bKeyframe)
+	{
+		recordHeader.Flags |= FRAME_CAPTURE_FLAG_KEYFRAME;
+		history.Pixels.assign(pixelCount, 0);
+		history.Width = Frame.Width;
+		history.Height = Frame.Height;
+	}
+
+	// XOR against the previous frame so unchanged pixels become 0, then run-length encode. Update the history along the way.
+	std::vector<uint32_t>& runs = Win32FrameCapture.EncodedRuns;
+	runs.clear();
+
+	// Index of the pixel count of the literal run short runs currently get appended to, none being open when SIZE_MAX.
+	size_t literalRunIndex = SIZE_MAX;
+
+	uint32_t* previousPixels = history.Pixels.data();
+	for (size_t pixelIndex = 0; pixelIndex < pixelCount;)
+	{
+		uint32_t value = Frame.Pixels[pixelIndex] ^ previousPixels[pixelIndex];
+		previousPixels[pixelIndex] = Frame.Pixels[pixelIndex];
+
+		uint32_t runLength = 1;
+		for (pixelIndex++; pixelIndex < pixelCount && (Frame.Pixels[pixelIndex] ^ previousPixels[pixelIndex]) == value
+			&& runLength < FRAME_CAPTURE_MAX_RUN_LENGTH; pixelIndex++)
+		{
+			previousPixels[pixelIndex] = Frame.Pixels[pixelIndex];
+			runLength++;
+		}
+
+		if (runLength >= FRAME_CAPTURE_MIN_REPEAT_RUN_LENGTH)
+		{
+			runs.push_back(runLength);
+			runs.push_back(value);
+			recordHeader.RunCount++;
+			literalRunIndex = SIZE_MAX;
+			continue;
+		}
+
+		if (literalRunIndex == SIZE_MAX || (runs[literalRunIndex] & FRAME_CAPTURE_MAX_RUN_LENGTH) > FRAME_CAPTURE_MAX_RUN_LENGTH - runLength)
+		{
+			literalRunIndex = runs.size();
+			runs.push_back(FRAME_CAPTURE_LITERAL_RUN_BIT);
+			recordHeader.RunCount++;
+		}
+
+		runs[literalRunIndex] += runLength;
+		runs.insert(runs.end(), runLength, value);
+	}
+
+	DWORD bytesWritten = 0;
+	bool bWritten = WriteFile(Win32FrameCapture.File, &recordHeader, sizeof(recordHeader), &bytesWritten, NULL)
+		&& WriteFile(Win32FrameCapture.File, runs.data(), (DWORD)(runs.size() * sizeof(uint32_t)), &bytesWritten, NULL);
+
+	if (!bWritten && !Win32FrameCapture.bWriteFailed)
+	{
+		std::cerr << "ERROR: Failed to write captured frame " << Frame.FrameNumber << ". Error Code = " << GetLastError() << "\n";
+		Win32FrameCapture.bWriteFailed = true;
+	}
+
+	Win32FrameCapture.RawBytes += pixelCount * sizeof(uint32_t);
+	Win32FrameCapture.WrittenBytes += sizeof(recordHeader) + runs.size() * sizeof(uint32_t);
+}
+
+/*
+	Frame capture writer thread entry point. Writes pending frames in order and hands their buffers back, until asked to stop and every pending
+	frame has been written.
+*/
+DWORD WINAPI FrameCaptureWriterThreadProc(LPVOID Parameter)
+{
+	AcquireSRWLockExclusive(&Win32FrameCapture.Lock);
+	while (true)
+	{
+		while (Win32FrameCapture.PendingFrames.empty() && !Win32FrameCapture.bStopRequested)
+		{
+			SleepConditionVariableSRW(&Win32FrameCapture.PendingFramesAvailable, &Win32FrameCapture.Lock, INFINITE, 0);
+		}
+
+		if (Win32FrameCapture.PendingFrames.empty())
+		{
+			break;
+		}
+
+		Win32CapturedFrame* frame = Win32FrameCapture.PendingFrames.front();
+		Win32FrameCapture.PendingFrames.erase(Win32FrameCapture.PendingFrames.begin());
+
+		// Encode and write without holding the lock so the main thread never waits on the disk.
+		ReleaseSRWLockExclusive(&Win32FrameCapture.Lock);
+		WriteCapturedFrame(*frame);
+		AcquireSRWLockExclusive(&Win32FrameCapture.Lock);
+
+		Win32FrameCapture.FreeFrames.push_back(frame);
+	}
+	ReleaseSRWLockExclusive(&Win32FrameCapture.Lock);
+
+	return 0;
+}
+
+bool Win32_BeginFrameCapture(const std::string& FilePath)
+{
+	Win32_EndFrameCapture();
+
+	Win32FrameCapture.File = CreateFileA(FilePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (Win32FrameCapture.File == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "ERROR: Failed to create frame capture file \"" << FilePath << "\". Error Code = " << GetLastError() << "\n";
+		return false;
+	}
+
+	Win32FrameCaptureFileHeader fileHeader = {};
+	DWORD bytesWritten = 0;
+	WriteFile(Win32FrameCapture.File, &fileHeader, sizeof(fileHeader), &bytesWritten, NULL);
+
+	// Reserve room for as many frames as can be in flight so the lists never re-allocate while capturing.
+	Win32FrameCapture.FreeFrames.reserve(FRAME_CAPTURE_BUFFER_COUNT);
+	Win32FrameCapture.PendingFrames.reserve(FRAME_CAPTURE_BUFFER_COUNT);
+	for (Win32CapturedFrame& frame : Win32FrameCapture.Frames)
+	{
+		Win32FrameCapture.FreeFrames.push_back(&frame);
+	}
+
+	Win32FrameCapture.WriterThread = CreateThread(NULL, 0, FrameCaptureWriterThreadProc, NULL, 0, NULL);
+	if (Win32FrameCapture.WriterThread == NULL)
+	{
+		std::cerr << "ERROR: Failed to start frame capture writer thread. Error Code = " << GetLastError() << "\n";
+		Win32_EndFrameCapture();
+		return false;
+	}
+
+	std::cout << "Capturing frames to \"" << FilePath << "\".\n";
+	return true;
+}
+
+void Win32_CaptureFrame(uint64_t FrameNumber, uint32_t ViewportIndex, const Win32PixelSurface& Surface)
+{
+	if (Win32FrameCapture.WriterThread == NULL || Surface.Pixels == nullptr)
+	{
+		return;
+	}
+
+	// Take a free frame buffer. If the writer is lagging behind and none are left, drop the frame rather than waiting.
+	Win32CapturedFrame* frame = nullptr;
+	AcquireSRWLockExclusive(&Win32FrameCapture.Lock);
+	if (!Win32FrameCapture.FreeFrames.empty())
+	{
+		frame = Win32FrameCapture.FreeFrames.back();
+		Win32FrameCapture.FreeFrames.pop_back();
+	}
+	ReleaseSRWLockExclusive(&Win32FrameCapture.Lock);
+
+	if (frame == nullptr)
+	{
+		Win32FrameCapture.DroppedFrameCount++;
+		return;
+	}
+
+	// Buffers only grow, so they stop being re-allocated once they've seen the largest surface.
+	size_t pixelCount = (size_t)(Surface.Width) * Surface.Height;
+	if (pixelCount > frame->PixelCapacity)
+	{
+		free(frame->Pixels);
+		frame->Pixels = (uint32_t*)(malloc(pixelCount * sizeof(uint32_t)));
+		frame->PixelCapacity = frame->Pixels != nullptr ? pixelCount : 0;
+	}
+
+	if (frame->Pixels == nullptr)
+	{
+		AcquireSRWLockExclusive(&Win32FrameCapture.Lock);
+		Win32FrameCapture.FreeFrames.push_back(frame);
+		ReleaseSRWLockExclusive(&Win32FrameCapture.Lock);
+
+		Win32FrameCapture.DroppedFrameCount++;
+		return;
+	}
+
+	// Copy the visible rows, leaving row padding out. This is the only cost capturing adds to frames, so it is timed for the statistics.
+	LARGE_INTEGER copyStart, copyEnd;
+	QueryPerformanceCounter(&copyStart);
+
+	for (uint16_t y = 0; y < Surface.Height; y++)
+	{
+		memcpy(frame->Pixels + (size_t)(y) * Surface.Width, Surface.Pixels + (size_t)(y) * Surface.Stride, Surface.Width * sizeof(uint32_t));
+	}
+
+	QueryPerformanceCounter(&copyEnd);
+	Win32FrameCapture.TotalCopyTicks += copyEnd.QuadPart - copyStart.QuadPart;
+	Win32FrameCapture.MaxCopyTicks = max(Win32FrameCapture.MaxCopyTicks, copyEnd.QuadPart - copyStart.QuadPart);
+
+	frame->FrameNumber = FrameNumber;
+	frame->ViewportIndex = ViewportIndex;
+	frame->Width = Surface.Width;
+	frame->Height = Surface.Height;
+
+	AcquireSRWLockExclusive(&Win32FrameCapture.Lock);
+	Win32FrameCapture.PendingFrames.push_back(frame);
+	ReleaseSRWLockExclusive(&Win32FrameCapture.Lock);
+	WakeConditionVariable(&Win32FrameCapture.PendingFramesAvailable);
+
+	Win32FrameCapture.CapturedFrameCount++;
+}
+
+void Win32_EndFrameCapture()
+{
+	if (Win32FrameCapture.WriterThread != NULL)
+	{
+		// Let the writer finish the pending frames.
+		AcquireSRWLockExclusive(&Win32FrameCapture.Lock);
+		Win32FrameCapture.bStopRequested = true;
+		ReleaseSRWLockExclusive(&Win32FrameCapture.Lock);
+		WakeConditionVariable(&Win32FrameCapture.PendingFramesAvailable);
+
+		WaitForSingleObject(Win32FrameCapture.WriterThread, INFINITE);
+		CloseHandle(Win32FrameCapture.WriterThread);
+
+		LARGE_INTEGER performanceFrequency;
+		QueryPerformanceFrequency(&performanceFrequency);
+
+		double totalCopyMilliseconds = Win32FrameCapture.TotalCopyTicks * 1000.0 / performanceFrequency.QuadPart;
+		double maxCopyMilliseconds = Win32FrameCapture.MaxCopyTicks * 1000.0 / performanceFrequency.QuadPart;
+
+		std::cout << "Frame capture done: " << Win32FrameCapture.CapturedFrameCount << " frames captured, " << Win32FrameCapture.DroppedFrameCount
+			<< " dropped, " << Win32FrameCapture.WrittenBytes << " bytes written for " << Win32FrameCapture.RawBytes << " bytes of pixels. Copying frames took "
+			<< (Win32FrameCapture.CapturedFrameCount > 0 ? totalCopyMilliseconds / Win32FrameCapture.CapturedFrameCount : 0.0) << " ms per frame on average, "
+			<< maxCopyMilliseconds << " ms at most.\n";
+	}
+
+	if (Win32FrameCapture.File != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(Win32FrameCapture.File);
+	}
+
+	for (Win32CapturedFrame& frame : Win32FrameCapture.Frames)
+	{
+		free(frame.Pixels);
+		frame = {};
+	}
+
+	Win32FrameCapture.File = INVALID_HANDLE_VALUE;
+	Win32FrameCapture.WriterThread = NULL;
+	Win32FrameCapture.FreeFrames.clear();
+	Win32FrameCapture.PendingFrames.clear();
+	Win32FrameCapture.bStopRequested = false;
+	Win32FrameCapture.ViewportHistories.clear();
+	Win32FrameCapture.EncodedRuns.clear();
+	Win32FrameCapture.CapturedFrameCount = 0;
+	Win32FrameCapture.DroppedFrameCount = 0;
+	Win32FrameCapture.TotalCopyTicks = 0;
+	Win32FrameCapture.MaxCopyTicks = 0;
+	Win32FrameCapture.RawBytes = 0;
+	Win32FrameCapture.WrittenBytes = 0;
+	Win32FrameCapture.bWriteFailed = false;
+}
\ No newline at end of file
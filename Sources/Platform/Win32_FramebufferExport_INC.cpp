@@ -0,0 +1,201 @@
+SOURCE_INC_FILE()
+
+// Symbol definitions for exporting viewport pixels through named shared memory, so other local processes can read frames without any copy.
+
+#include "Platform/Win32_Platform.h"
+
+#include <string>
+
+// Identifies exported framebuffers ("SYFB" in little endian) and the version of their header.
+#define FRAMEBUFFER_EXPORT_MAGIC (0x42465953)
+#define FRAMEBUFFER_EXPORT_VERSION (2)
+
+// Size of the shared memory holding the header.
+#define FRAMEBUFFER_EXPORT_HEADER_SIZE (4096)
+
+/*
+	Header found in the shared memory named after the export. Pixels live in separate shared memory named "<export name>_<Generation>", as Height
+	rows of Stride 32 bits BGRX pixels of which the first Width are visible. Pixel shared memory is sized for the viewport, and replaced by larger
+	memory of the next generation whenever the viewport outgrows it.
+
+	Readers must follow the sequence lock protocol: read Sequence, retry later if it is odd (a frame is being rendered), open the pixel shared
+	memory again if Generation changed, read the frame, then read Sequence again and discard the frame if it changed.
+*/
+struct Win32FramebufferExportHeader
+{
+	uint32_t Magic = FRAMEBUFFER_EXPORT_MAGIC;
+	uint32_t Version = FRAMEBUFFER_EXPORT_VERSION;
+
+	// Generation of the pixel shared memory, and bytes available in it.
+	uint32_t Generation = 0;
+	uint32_t Padding = 0;
+	uint64_t PixelCapacity = 0;
+
+	// Incremented when rendering a frame starts and when it ends.
+	std::atomic<uint64_t> Sequence{ 0 };
+
+	// Frame the pixels are from. Width is 0 while nothing can be exported, such as when larger pixel shared memory couldn't be created.
+	uint64_t FrameNumber = 0;
+	uint16_t Width = 0;
+	uint16_t Height = 0;
+	uint32_t Stride = 0;
+};
+
+static_assert(sizeof(Win32FramebufferExportHeader) <= FRAMEBUFFER_EXPORT_HEADER_SIZE, "Framebuffer export header must fit before the pixels.");
+
+/*
+	Creates the named shared memory Size bytes are exported through. Fails if the name is already in use, as the existing memory may be too small.
+	Returns NULL on failure.
+*/
+HANDLE CreateFramebufferExportMapping(const std::string& Name, uint64_t Size)
+{
+	HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(Size >> 32), (DWORD)(Size), Name.c_str());
+	if (mapping == NULL)
+	{
+		std::cerr << "ERROR: Failed to create shared memory \"" << Name << "\" for framebuffer export. Error Code = " << GetLastError() << "\n";
+		return NULL;
+	}
+
+	if (GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		std::cerr << "ERROR: Shared memory \"" << Name << "\" already exists. Framebuffer export disabled for it.\n";
+		CloseHandle(mapping);
+		return NULL;
+	}
+
+	return mapping;
+}
+
+bool Win32_OpenFramebufferExport(Win32FramebufferExport& Export, const std::string& Name, uint64_t PixelCapacity)
+{
+	Win32_CloseFramebufferExport(Export);
+
+	Export.Name = Name;
+	Export.HeaderMapping = CreateFramebufferExportMapping(Name, FRAMEBUFFER_EXPORT_HEADER_SIZE);
+	Export.PixelMapping = Export.HeaderMapping != NULL ? CreateFramebufferExportMapping(Name + "_0", PixelCapacity) : NULL;
+	if (Export.PixelMapping == NULL)
+	{
+		Win32_CloseFramebufferExport(Export);
+		return false;
+	}
+
+	// Only the header is mapped here. Pixels get mapped by the surface bitmaps placed in the pixel section.
+	Export.Header = (Win32FramebufferExportHeader*)(MapViewOfFile(Export.HeaderMapping, FILE_MAP_WRITE, 0, 0, FRAMEBUFFER_EXPORT_HEADER_SIZE));
+	if (Export.Header == nullptr)
+	{
+		std::cerr << "ERROR: Failed to map shared memory \"" << Name << "\" for framebuffer export. Error Code = " << GetLastError() << "\n";
+		Win32_CloseFramebufferExport(Export);
+		return false;
+	}
+
+	new (Export.Header) Win32FramebufferExportHeader();
+	Export.Header->PixelCapacity = PixelCapacity;
+	Export.PixelCapacity = PixelCapacity;
+
+	std::cout << "Exporting framebuffer to shared memory \"" << Name << "\".\n";
+	return true;
+}
+
+bool Win32_ResizeExportedPixelSurface(Win32FramebufferExport& Export, Win32PixelSurface& Surface, uint16_t Width, uint16_t Height)
+{
+	uint64_t alignedWidth = ((uint64_t)(Width) + WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT - 1) / WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT * WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT;
+	uint64_t requiredBytes = max(alignedWidth, (uint64_t)(WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT)) * max((uint64_t)(Height), 1ull) * sizeof(Win32PixelRGBA);
+
+	if (Export.Header == nullptr)
+	{
+		return false;
+	}
+
+	// Readers must not see the surface change under them.
+	Export.Header->Sequence.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	bool bCreated = false;
+	if (requiredBytes <= Export.PixelCapacity)
+	{
+		bCreated = Win32_CreatePixelSurfaceOnSection(Surface, Width, Height, Export.PixelMapping, 0);
+	}
+	else
+	{
+		// Move the pixels to larger shared memory of the next generation. Grow by half at least, so resizing a window doesn't do this every frame.
+		uint64_t newPixelCapacity = max(requiredBytes, Export.PixelCapacity + Export.PixelCapacity / 2);
+		uint32_t newGeneration = Export.Header->Generation + 1;
+
+		HANDLE newPixelMapping = CreateFramebufferExportMapping(Export.Name + "_" + std::to_string(newGeneration), newPixelCapacity);
+		if (newPixelMapping != NULL)
+		{
+			bCreated = Win32_CreatePixelSurfaceOnSection(Surface, Width, Height, newPixelMapping, 0);
+		}
+
+		if (bCreated)
+		{
+			// Readers still mapping the previous generation keep it alive until they move on.
+			CloseHandle(Export.PixelMapping);
+			Export.PixelMapping = newPixelMapping;
+			Export.PixelCapacity = newPixelCapacity;
+			Export.Header->Generation = newGeneration;
+			Export.Header->PixelCapacity = newPixelCapacity;
+		}
+		else if (newPixelMapping != NULL)
+		{
+			CloseHandle(newPixelMapping);
+		}
+	}
+
+	// Nothing valid gets exported until the next frame is done.
+	Export.Header->Width = 0;
+	Export.Header->Height = 0;
+	Export.Header->Sequence.fetch_add(1, std::memory_order_release);
+
+	return bCreated;
+}
+
+void Win32_BeginExportedFrame(Win32FramebufferExport& Export)
+{
+	if (Export.Header == nullptr)
+	{
+		return;
+	}
+
+	// The fence keeps pixel writes of the frame from being seen before the odd sequence number.
+	Export.Header->Sequence.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void Win32_EndExportedFrame(Win32FramebufferExport& Export, uint64_t FrameNumber, const Win32PixelSurface& Surface)
+{
+	if (Export.Header == nullptr)
+	{
+		return;
+	}
+
+	// Only frames rendered into the shared memory itself are exported.
+	bool bExported = Surface.bOnSection;
+	Export.Header->FrameNumber = FrameNumber;
+	Export.Header->Width = bExported ? Surface.Width : 0;
+	Export.Header->Height = bExported ? Surface.Height : 0;
+	Export.Header->Stride = bExported ? Surface.Stride : 0;
+
+	// Release ordering makes pixels and header visible to readers before the even sequence number.
+	Export.Header->Sequence.fetch_add(1, std::memory_order_release);
+}
+
+void Win32_CloseFramebufferExport(Win32FramebufferExport& Export)
+{
+	if (Export.Header != nullptr)
+	{
+		UnmapViewOfFile(Export.Header);
+	}
+
+	if (Export.PixelMapping != NULL)
+	{
+		CloseHandle(Export.PixelMapping);
+	}
+
+	if (Export.HeaderMapping != NULL)
+	{
+		CloseHandle(Export.HeaderMapping);
+	}
+
+	Export = {};
+}
\ No newline at end of file
@@ -0,0 +1,205 @@
+SOURCE_INC_FILE()
+
+// Symbol definitions for recording client frame input to disk and replaying it deterministically, for reproducible performance runs.
+
+#include "SynergyClientAPI.h"
+#include "Platform/Win32_Platform.h"
+
+#include <vector>
+
+// Identifies input recording files ("SYIR" in little endian) and the version of their layout.
+#define INPUT_RECORDING_MAGIC (0x52495953)
+#define INPUT_RECORDING_VERSION (1)
+
+/*
+	Header found at the start of every input recording file.
+	Client API structures are stored as is, so recordings are only valid for builds sharing the same ActionInputEvent layout. Its size is
+	stored for a minimal sanity check.
+*/
+struct Win32InputRecordingFileHeader
+{
+	uint32_t Magic = INPUT_RECORDING_MAGIC;
+	uint32_t Version = INPUT_RECORDING_VERSION;
+	uint32_t EventSize = sizeof(ActionInputEvent);
+};
+
+// Header of a single recorded frame, immediately followed by EventCount Action Input Events.
+struct Win32InputRecordingFrameHeader
+{
+	uint64_t FrameNumber = 0;
+	float FrameTime = 0.f;
+	Vector2s CursorLocation = {};
+	ViewportID CursorViewport = 0;
+	uint32_t EventCount = 0;
+};
+
+// State of the input recording & replay system.
+struct Win32InputRecordingContext
+{
+	// File frames get appended to while recording. Null when not recording.
+	FILE* RecordingFile = nullptr;
+
+	// Entire content of the replayed recording, loaded up front so replaying never waits on the disk. Empty when not replaying.
+	std::vector<uint8_t> ReplayData;
+
+	// Read position in the replayed recording.
+	size_t ReplayCursor = 0;
+
+	// Events of the frame currently being replayed, copied out of the recording so they are correctly aligned for the client.
+	std::vector<ActionInputEvent> ReplayFrameEvents;
+};
+
+static Win32InputRecordingContext Win32InputRecording;
+
+bool Win32_BeginInputRecording(const std::string& FilePath)
+{
+	Win32_EndInputRecording();
+
+	if (fopen_s(&Win32InputRecording.RecordingFile, FilePath.c_str(), "wb") != 0 || Win32InputRecording.RecordingFile == nullptr)
+	{
+		std::cerr << "ERROR: Failed to open input recording file \"" << FilePath << "\" for writing.\n";
+		Win32InputRecording.RecordingFile = nullptr;
+		return false;
+	}
+
+	Win32InputRecordingFileHeader fileHeader = {};
+	fwrite(&fileHeader, sizeof(fileHeader), 1, Win32InputRecording.RecordingFile);
+
+	std::cout << "Recording input to \"" << FilePath << "\".\n";
+	return true;
+}
+
+void Win32_RecordFrameInput(const ClientFrameRequestData& FrameData)
+{
+	if (Win32InputRecording.RecordingFile == nullptr)
+	{
+		return;
+	}
+
+	// Zero the padding as well, so recordings never contain uninitialized bytes.
+	Win32InputRecordingFrameHeader frameHeader;
+	memset(&frameHeader, 0, sizeof(frameHeader));
+	frameHeader.FrameNumber = FrameData.FrameNumber;
+	frameHeader.FrameTime = FrameData.FrameTime;
+	frameHeader.CursorLocation = FrameData.CursorLocation;
+	frameHeader.CursorViewport = FrameData.CursorViewport;
+	frameHeader.EventCount = (uint32_t)(FrameData.ActionInputEvents.EventCount);
+
+	fwrite(&frameHeader, sizeof(frameHeader), 1, Win32InputRecording.RecordingFile);
+	if (frameHeader.EventCount > 0)
+	{
+		fwrite(FrameData.ActionInputEvents.Buffer, sizeof(ActionInputEvent), frameHeader.EventCount, Win32InputRecording.RecordingFile);
+	}
+}
+
+void Win32_EndInputRecording()
+{
+	if (Win32InputRecording.RecordingFile != nullptr)
+	{
+		fclose(Win32InputRecording.RecordingFile);
+		Win32InputRecording.RecordingFile = nullptr;
+	}
+}
+
+bool Win32_BeginInputReplay(const std::string& FilePath)
+{
+	Win32_EndInputReplay();
+
+	FILE* replayFile = nullptr;
+	if (fopen_s(&replayFile, FilePath.c_str(), "rb") != 0 || replayFile == nullptr)
+	{
+		std::cerr << "ERROR: Failed to open input recording file \"" << FilePath << "\" for replay.\n";
+		return false;
+	}
+
+	// Load the whole recording in memory.
+	_fseeki64(replayFile, 0, SEEK_END);
+	int64_t fileSize = _ftelli64(replayFile);
+	_fseeki64(replayFile, 0, SEEK_SET);
+
+	if (fileSize > 0)
+	{
+		Win32InputRecording.ReplayData.resize((size_t)(fileSize));
+		if (fread(Win32InputRecording.ReplayData.data(), 1, (size_t)(fileSize), replayFile) != (size_t)(fileSize))
+		{
+			Win32InputRecording.ReplayData.clear();
+		}
+	}
+	fclose(replayFile);
+
+	// Validate file header.
+	Win32InputRecordingFileHeader expectedHeader = {};
+	Win32InputRecordingFileHeader fileHeader = {};
+	if (Win32InputRecording.ReplayData.size() < sizeof(fileHeader))
+	{
+		std::cerr << "ERROR: Failed to read input recording file \"" << FilePath << "\".\n";
+		Win32_EndInputReplay();
+		return false;
+	}
+
+	memcpy(&fileHeader, Win32InputRecording.ReplayData.data(), sizeof(fileHeader));
+	if (fileHeader.Magic != expectedHeader.Magic || fileHeader.Version != expectedHeader.Version || fileHeader.EventSize != expectedHeader.EventSize)
+	{
+		std::cerr << "ERROR: \"" << FilePath << "\" is not an input recording compatible with this build.\n";
+		Win32_EndInputReplay();
+		return false;
+	}
+
+	Win32InputRecording.ReplayCursor = sizeof(fileHeader);
+
+	std::cout << "Replaying input from \"" << FilePath << "\".\n";
+	return true;
+}
+
+bool Win32_IsReplayingInput()
+{
+	return !Win32InputRecording.ReplayData.empty();
+}
+
+bool Win32_ReplayFrameInput(ClientFrameRequestData& FrameData)
+{
+	std::vector<uint8_t>& replayData = Win32InputRecording.ReplayData;
+	size_t& replayCursor = Win32InputRecording.ReplayCursor;
+
+	if (replayData.size() - replayCursor < sizeof(Win32InputRecordingFrameHeader))
+	{
+		// End of recording.
+		return false;
+	}
+
+	Win32InputRecordingFrameHeader frameHeader;
+	memcpy(&frameHeader, replayData.data() + replayCursor, sizeof(frameHeader));
+	replayCursor += sizeof(frameHeader);
+
+	size_t eventsSize = frameHeader.EventCount * sizeof(ActionInputEvent);
+	if (replayData.size() - replayCursor < eventsSize)
+	{
+		std::cerr << "ERROR: Input recording is truncated at frame " << frameHeader.FrameNumber << ". Ending replay.\n";
+		replayCursor = replayData.size();
+		return false;
+	}
+
+	Win32InputRecording.ReplayFrameEvents.resize(frameHeader.EventCount);
+	if (eventsSize > 0)
+	{
+		memcpy(Win32InputRecording.ReplayFrameEvents.data(), replayData.data() + replayCursor, eventsSize);
+	}
+	replayCursor += eventsSize;
+
+	// Substitute recorded frame input for live input.
+	FrameData.FrameTime = frameHeader.FrameTime;
+	FrameData.CursorLocation = frameHeader.CursorLocation;
+	FrameData.CursorViewport = frameHeader.CursorViewport;
+	FrameData.ActionInputEvents.Buffer = Win32InputRecording.ReplayFrameEvents.data();
+	FrameData.ActionInputEvents.EventCount = frameHeader.EventCount;
+
+	return true;
+}
+
+void Win32_EndInputReplay()
+{
+	Win32InputRecording.ReplayData.clear();
+	Win32InputRecording.ReplayData.shrink_to_fit();
+	Win32InputRecording.ReplayFrameEvents.clear();
+	Win32InputRecording.ReplayCursor = 0;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+SOURCE_INC_FILE()
+
+// Symbol definitions for the lock-free input record queue shared between the Input thread and the main thread.
+
+#include "Platform/Win32_Platform.h"
+
+bool Win32InputQueue::Push(const Win32InputRecord& Record)
+{
+	size_t writeIndex = WriteIndex.load(std::memory_order_relaxed);
+	size_t readIndex = ReadIndex.load(std::memory_order_acquire);
+
+	if (Records == nullptr || writeIndex - readIndex >= Capacity)
+	{
+		// Queue is full.
+		return false;
+	}
+
+	Records[writeIndex & (Capacity - 1)] = Record;
+
+	// Publish the record. Release ordering guarantees the consumer sees its content once it sees the new Write Index.
+	WriteIndex.store(writeIndex + 1, std::memory_order_release);
+	return true;
+}
+
+bool Win32InputQueue::Pop(Win32InputRecord& OutRecord)
+{
+	size_t readIndex = ReadIndex.load(std::memory_order_relaxed);
+	size_t writeIndex = WriteIndex.load(std::memory_order_acquire);
+
+	if (readIndex == writeIndex)
+	{
+		// Queue is empty.
+		return false;
+	}
+
+	OutRecord = Records[readIndex & (Capacity - 1)];
+
+	// Hand the slot back to the producer.
+	ReadIndex.store(readIndex + 1, std::memory_order_release);
+	return true;
+}
+
+bool Win32InputQueue::IsEmpty() const
+{
+	return ReadIndex.load(std::memory_order_relaxed) == WriteIndex.load(std::memory_order_acquire);
+}
\ No newline at end of file
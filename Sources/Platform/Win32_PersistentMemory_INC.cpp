@@ -0,0 +1,149 @@
+SOURCE_INC_FILE()
+
+// Symbol definitions for backing client persistent memory with a memory-mapped file, so a relaunch can resume from the previous session's state.
+
+#include "Platform/Win32_Platform.h"
+
+// Identifies persistent memory files ("SYPM" in little endian) and the version of their header.
+#define PERSISTENT_MEMORY_FILE_MAGIC (0x4D505953)
+#define PERSISTENT_MEMORY_FILE_VERSION (1)
+
+// Client memory starts one page into the file so that it is page aligned once mapped.
+#define PERSISTENT_MEMORY_FILE_HEADER_SIZE (4096)
+
+// Header found at the start of every persistent memory file.
+struct Win32PersistentMemoryFileHeader
+{
+	uint32_t Magic = PERSISTENT_MEMORY_FILE_MAGIC;
+	uint32_t Version = PERSISTENT_MEMORY_FILE_VERSION;
+
+	// Layout version of the client memory, as provided by the client library.
+	uint32_t LayoutVersion = 0;
+	uint32_t Padding = 0;
+
+	// Size of the client memory, in bytes.
+	uint64_t MemorySize = 0;
+
+	/*
+		Address the client memory was mapped at. Client memory may hold pointers to itself, so it is only resumed when it can be mapped back
+		at the same address.
+	*/
+	uint64_t BaseAddress = 0;
+};
+
+// State of the persistent memory file mapping.
+struct Win32PersistentMemoryContext
+{
+	HANDLE File = INVALID_HANDLE_VALUE;
+	HANDLE Mapping = NULL;
+	uint8_t* MappedView = nullptr;
+};
+
+static Win32PersistentMemoryContext Win32PersistentMemory;
+
+void* Win32_MapPersistentMemoryFile(const std::string& FilePath, size_t MemorySize, uint32_t LayoutVersion, bool& bOutResumed)
+{
+	bOutResumed = false;
+	Win32_UnmapPersistentMemoryFile();
+
+	Win32PersistentMemory.File = CreateFileA(FilePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (Win32PersistentMemory.File == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "ERROR: Failed to open persistent memory file \"" << FilePath << "\". Error Code = " << GetLastError() << "\n";
+		return nullptr;
+	}
+
+	// Read header of the previous session, if any, before mapping so we know which address to map at.
+	Win32PersistentMemoryFileHeader expectedHeader = {};
+	expectedHeader.LayoutVersion = LayoutVersion;
+	expectedHeader.MemorySize = MemorySize;
+
+	Win32PersistentMemoryFileHeader previousHeader = {};
+	DWORD bytesRead = 0;
+	bool bPreviousHeaderValid = ReadFile(Win32PersistentMemory.File, &previousHeader, sizeof(previousHeader), &bytesRead, NULL)
+		&& bytesRead == sizeof(previousHeader)
+		&& previousHeader.Magic == expectedHeader.Magic
+		&& previousHeader.Version == expectedHeader.Version
+		&& previousHeader.LayoutVersion == expectedHeader.LayoutVersion
+		&& previousHeader.MemorySize == expectedHeader.MemorySize;
+
+	uint64_t fileSize = PERSISTENT_MEMORY_FILE_HEADER_SIZE + (uint64_t)(MemorySize);
+	Win32PersistentMemory.Mapping = CreateFileMappingA(Win32PersistentMemory.File, NULL, PAGE_READWRITE, (DWORD)(fileSize >> 32), (DWORD)(fileSize), NULL);
+	if (Win32PersistentMemory.Mapping == NULL)
+	{
+		std::cerr << "ERROR: Failed to map persistent memory file \"" << FilePath << "\". Error Code = " << GetLastError() << "\n";
+		Win32_UnmapPersistentMemoryFile();
+		return nullptr;
+	}
+
+	// Try mapping the file back where it was, then anywhere.
+	if (bPreviousHeaderValid)
+	{
+		Win32PersistentMemory.MappedView = (uint8_t*)(MapViewOfFileEx(Win32PersistentMemory.Mapping, FILE_MAP_WRITE, 0, 0, 0,
+			(void*)(previousHeader.BaseAddress - PERSISTENT_MEMORY_FILE_HEADER_SIZE)));
+	}
+
+	if (Win32PersistentMemory.MappedView == nullptr)
+	{
+		Win32PersistentMemory.MappedView = (uint8_t*)(MapViewOfFile(Win32PersistentMemory.Mapping, FILE_MAP_WRITE, 0, 0, 0));
+	}
+
+	if (Win32PersistentMemory.MappedView == nullptr)
+	{
+		std::cerr << "ERROR: Failed to map persistent memory file \"" << FilePath << "\" in memory. Error Code = " << GetLastError() << "\n";
+		Win32_UnmapPersistentMemoryFile();
+		return nullptr;
+	}
+
+	uint8_t* clientMemory = Win32PersistentMemory.MappedView + PERSISTENT_MEMORY_FILE_HEADER_SIZE;
+	bOutResumed = bPreviousHeaderValid && previousHeader.BaseAddress == (uint64_t)(clientMemory);
+
+	if (bOutResumed)
+	{
+		std::cout << "Resumed client persistent memory from \"" << FilePath << "\".\n";
+	}
+	else
+	{
+		if (bPreviousHeaderValid)
+		{
+			std::cerr << "WARNING: Could not map persistent memory back at its previous address. Starting from blank persistent memory.\n";
+		}
+
+		// Start from zeroed out memory and stamp the header for the next session.
+		memset(clientMemory, 0, MemorySize);
+
+		expectedHeader.BaseAddress = (uint64_t)(clientMemory);
+		memcpy(Win32PersistentMemory.MappedView, &expectedHeader, sizeof(expectedHeader));
+
+		std::cout << "Mapped blank client persistent memory to \"" << FilePath << "\".\n";
+	}
+
+	return clientMemory;
+}
+
+bool Win32_IsPersistentMemoryFileMapped()
+{
+	return Win32PersistentMemory.MappedView != nullptr;
+}
+
+void Win32_UnmapPersistentMemoryFile()
+{
+	if (Win32PersistentMemory.MappedView != nullptr)
+	{
+		// Make sure the state reaches the disk, so it survives even an OS crash.
+		FlushViewOfFile(Win32PersistentMemory.MappedView, 0);
+		UnmapViewOfFile(Win32PersistentMemory.MappedView);
+	}
+
+	if (Win32PersistentMemory.Mapping != NULL)
+	{
+		CloseHandle(Win32PersistentMemory.Mapping);
+	}
+
+	if (Win32PersistentMemory.File != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(Win32PersistentMemory.File);
+	}
+
+	Win32PersistentMemory = {};
+}
\ No newline at end of file
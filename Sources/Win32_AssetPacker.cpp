@@ -0,0 +1,196 @@
+/*
+	Build-side tool packing every file found in a folder, recursively, into an asset pack (see SynergyAssetPack.h) for the platform to mount.
+	Assets are named after their path relative to the folder.
+
+	Usage: SynergyAssetPacker <source folder> <output pack>
+*/
+
+#include "SynergyAssetPack.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Size of the chunks asset files get copied into the pack with.
+#define ASSET_PACKER_COPY_CHUNK_SIZE (1024 * 1024)
+
+struct PackedAsset
+{
+	// Normalized asset name, and the path of the file the asset is read from.
+	std::string Name;
+	std::string SourcePath;
+
+	uint64_t NameHash = 0;
+	uint64_t Size = 0;
+};
+
+// Adds every file found in Folder and its sub-folders to OutAssets, naming them NamePrefix followed by their path relative to Folder.
+bool CollectAssets(const std::string& Folder, const std::string& NamePrefix, std::vector<PackedAsset>& OutAssets)
+{
+	WIN32_FIND_DATAA findData;
+	HANDLE findHandle = FindFirstFileExA((Folder + "\\*").c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+	if (findHandle == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "ERROR: Could not list folder \"" << Folder << "\". Error Code = " << GetLastError() << "\n";
+		return false;
+	}
+
+	bool bSuccess = true;
+	do
+	{
+		std::string fileName = findData.cFileName;
+		if (fileName == "." || fileName == "..")
+		{
+			continue;
+		}
+
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			bSuccess &= CollectAssets(Folder + "\\" + fileName, NamePrefix + fileName + "/", OutAssets);
+			continue;
+		}
+
+		PackedAsset asset;
+		asset.Name = NamePrefix + fileName;
+		std::transform(asset.Name.begin(), asset.Name.end(), asset.Name.begin(), AssetPackNormalizeNameCharacter);
+		asset.SourcePath = Folder + "\\" + fileName;
+		asset.NameHash = AssetPackHashName(asset.Name.c_str());
+		asset.Size = ((uint64_t)(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+		OutAssets.push_back(asset);
+	}
+	while (FindNextFileA(findHandle, &findData));
+
+	FindClose(findHandle);
+	return bSuccess;
+}
+
+// Writes Size zero bytes to the file.
+bool WritePadding(FILE* File, uint64_t Size)
+{
+	static const uint8_t zeroes[ASSET_PACK_BLOB_ALIGNMENT] = {};
+	return Size == 0 || fwrite(zeroes, 1, (size_t)(Size), File) == Size;
+}
+
+// Returns Offset rounded up to the blob alignment.
+uint64_t AlignBlobOffset(uint64_t Offset)
+{
+	return (Offset + ASSET_PACK_BLOB_ALIGNMENT - 1) / ASSET_PACK_BLOB_ALIGNMENT * ASSET_PACK_BLOB_ALIGNMENT;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3)
+	{
+		std::cerr << "Usage: SynergyAssetPacker <source folder> <output pack>\n";
+		return 1;
+	}
+
+	std::string sourceFolder = argv[1];
+	std::string outputPath = argv[2];
+
+	std::vector<PackedAsset> assets;
+	if (!CollectAssets(sourceFolder, "", assets))
+	{
+		return 1;
+	}
+
+	// Entries get sorted by name hash so the platform can binary search them. Names with the same hash can't be told apart that way.
+	std::sort(assets.begin(), assets.end(), [](const PackedAsset& A, const PackedAsset& B) { return A.NameHash < B.NameHash; });
+	for (size_t assetIndex = 1; assetIndex < assets.size(); assetIndex++)
+	{
+		if (assets[assetIndex].NameHash == assets[assetIndex - 1].NameHash)
+		{
+			std::cerr << "ERROR: Assets \"" << assets[assetIndex - 1].Name << "\" and \"" << assets[assetIndex].Name
+				<< "\" have the same name hash. Rename one of them.\n";
+			return 1;
+		}
+	}
+
+	// Lay the pack out: header, entries, names, then data blobs.
+	AssetPackHeader header = {};
+	header.Magic = ASSET_PACK_MAGIC;
+	header.Version = ASSET_PACK_VERSION;
+	header.EntryCount = (uint32_t)(assets.size());
+	header.EntriesOffset = sizeof(AssetPackHeader);
+	header.NamesOffset = header.EntriesOffset + assets.size() * sizeof(AssetPackEntry);
+
+	std::vector<AssetPackEntry> entries(assets.size());
+	std::string names;
+	for (size_t assetIndex = 0; assetIndex < assets.size(); assetIndex++)
+	{
+		entries[assetIndex].NameHash = assets[assetIndex].NameHash;
+		entries[assetIndex].NameOffset = names.size();
+		entries[assetIndex].DataSize = assets[assetIndex].Size;
+
+		names += assets[assetIndex].Name;
+		names += '\0';
+	}
+	header.NamesSize = names.size();
+
+	uint64_t dataOffset = header.NamesOffset + header.NamesSize;
+	for (AssetPackEntry& entry : entries)
+	{
+		dataOffset = AlignBlobOffset(dataOffset);
+		entry.DataOffset = dataOffset;
+		dataOffset += entry.DataSize;
+	}
+
+	FILE* packFile = nullptr;
+	if (fopen_s(&packFile, outputPath.c_str(), "wb") != 0 || packFile == nullptr)
+	{
+		std::cerr << "ERROR: Could not create asset pack \"" << outputPath << "\".\n";
+		return 1;
+	}
+
+	bool bSuccess = fwrite(&header, sizeof(header), 1, packFile) == 1
+		&& (entries.empty() || fwrite(entries.data(), sizeof(AssetPackEntry), entries.size(), packFile) == entries.size())
+		&& fwrite(names.data(), 1, names.size(), packFile) == names.size();
+
+	// Copy asset files in, each on its own aligned offset.
+	std::vector<uint8_t> copyBuffer(ASSET_PACKER_COPY_CHUNK_SIZE);
+	uint64_t writeOffset = header.NamesOffset + header.NamesSize;
+	for (size_t assetIndex = 0; bSuccess && assetIndex < assets.size(); assetIndex++)
+	{
+		bSuccess = WritePadding(packFile, entries[assetIndex].DataOffset - writeOffset);
+		writeOffset = entries[assetIndex].DataOffset;
+
+		FILE* assetFile = nullptr;
+		if (!bSuccess || fopen_s(&assetFile, assets[assetIndex].SourcePath.c_str(), "rb") != 0 || assetFile == nullptr)
+		{
+			std::cerr << "ERROR: Could not read asset \"" << assets[assetIndex].SourcePath << "\".\n";
+			bSuccess = false;
+			break;
+		}
+
+		// Copy exactly the size listed in the entry, so a file changing in the meantime can't break the layout.
+		uint64_t bytesLeft = entries[assetIndex].DataSize;
+		while (bSuccess && bytesLeft > 0)
+		{
+			size_t chunkSize = (size_t)(min(bytesLeft, (uint64_t)(copyBuffer.size())));
+			bSuccess = fread(copyBuffer.data(), 1, chunkSize, assetFile) == chunkSize && fwrite(copyBuffer.data(), 1, chunkSize, packFile) == chunkSize;
+			bytesLeft -= chunkSize;
+		}
+		fclose(assetFile);
+
+		if (!bSuccess)
+		{
+			std::cerr << "ERROR: Failed to copy asset \"" << assets[assetIndex].SourcePath << "\" into the pack.\n";
+		}
+		writeOffset += entries[assetIndex].DataSize;
+	}
+
+	bSuccess &= fclose(packFile) == 0;
+	if (!bSuccess)
+	{
+		DeleteFileA(outputPath.c_str());
+		return 1;
+	}
+
+	std::cout << "Packed " << assets.size() << " assets into \"" << outputPath << "\" (" << writeOffset << " bytes).\n";
+	return 0;
+}
\ No newline at end of file
@@ -1,14 +1,33 @@
 #define TRANSLATION_UNIT Win32_Main
 
 #include "SynergyClientAPI.h"
+#include "SynergyPlatformDrawingAPI.h"
+#include "SynergyPlatformRenderStatsAPI.h"
 #include "Platform/Win32_Platform.h"
 
 #include <vector>
 
 // Source includes
+#include "Platform/Win32_Allocators_INC.cpp"
+#include "Platform/Win32_AssetPack_INC.cpp"
+#include "Platform/Win32_ClientHost_INC.cpp"
 #include "Platform/Win32_ClientLibLoader_INC.cpp"
 #include "Platform/Win32_Drawing_INC.cpp"
+#include "Platform/Win32_DrawCallTrace_INC.cpp"
+#include "Platform/Win32_FileIO_INC.cpp"
 #include "Platform/Win32_FileManagement_INC.cpp"
+#include "Platform/Win32_FrameCapture_INC.cpp"
+#include "Platform/Win32_FramebufferExport_INC.cpp"
+#include "Platform/Win32_Input_INC.cpp"
+#include "Platform/Win32_InputRecording_INC.cpp"
+#include "Platform/Win32_PersistentMemory_INC.cpp"
+
+// Messages handled by the Input thread's message-only window on behalf of the main thread.
+#define WM_SYNERGY_CREATE_VIEWPORT_WINDOW (WM_APP + 1)
+#define WM_SYNERGY_DESTROY_VIEWPORT_WINDOW (WM_APP + 2)
+
+static const LPCWSTR MAIN_WINDOW_CLASS_NAME = L"Synergy Main Window Class";
+static const LPCWSTR INPUT_THREAD_WINDOW_CLASS_NAME = L"Synergy Input Thread Window Class";
 
 /* 
 	Viewport structure for the Win32 Platform, created by request of the Client.
@@ -30,37 +49,149 @@ struct Win32Viewport
 	// Display name of the viewport.
 	WCHAR* Name = ERROR_NAME; 
 
-	// Window & Bitmap data
+	// Window data
 	HWND Win32WindowHandle = NULL;
 	HDC Win32WindowDC = NULL;
-	HBITMAP DrawingBitmap = NULL;
-	HDC DrawingBitmapDC = NULL;
 
-	// Render Pixel data
-	Win32PixelRGBA* PixelBuffer = nullptr;
-	uint16_t PixelBufferWidth = 0;
-	uint16_t PixelBufferHeight = 0;
+	// Size of the window's client area (Dimensions for headless viewports). Draw call coordinates are relative to it.
+	uint16_t WindowWidth = 0;
+	uint16_t WindowHeight = 0;
+
+	/*
+		Window visibility state. Viewports that can't be seen aren't rasterized nor presented, but their client keeps running.
+		Occlusion by other windows isn't tracked, as it can't be reliably detected with desktop composition.
+	*/
+	bool bMinimized = false;
+	bool bHidden = false;
+
+	// Fraction of the window size pixels get rasterized at. Surfaces rendered at a lower resolution get stretched over the window when presenting.
+	float RenderScale = 1.f;
+
+	// Render Pixel data, sized after the window's client area and render scale.
+	Win32PixelSurface Surface;
+
+	// Shared memory the Surface is placed in when exporting framebuffers, so other processes can read it.
+	Win32FramebufferExport FramebufferExport;
 
 	// Draw Call buffer, filled in via client requests.
 	Win32DrawCallBuffer ClientDrawCallBuffer;
+
+	// What rendering the last frame took, for the client and the F8 info dump.
+	PlatformRenderStats RenderStats = {};
 };
 
-// Buffer for holding Action inputs recorded by the Win32 platform.
+/*
+	Buffer for holding Action inputs recorded by the Win32 platform over a frame.
+	Grows as needed so that no key or button transition ever gets lost, even over very long frames.
+*/
 struct Win32ActionInputBuffer
 {
-	ActionInputEvent* Buffer;
-	size_t EventCount;
-	size_t MaxEventCount;
+	ActionInputEvent* Buffer = nullptr;
+	size_t EventCount = 0;
+	size_t MaxEventCount = 0;
 };
 
-// Global context state for the Win32 application layer.
-struct Win32AppContext
+// Initial capacity of the Action Input buffer. It doubles in size whenever it gets full.
+#define ACTION_INPUT_BUFFER_INITIAL_CAPACITY (64)
+
+// Size of the persistent memory every client session gets, and of the frame memory each of its frames gets.
+#define CLIENT_PERSISTENT_MEMORY_SIZE (1024 * 68)
+#define CLIENT_FRAME_MEMORY_SIZE (1024 * 16)
+
+// Frame count hosted sessions run for when none is given on the command line (-frames <count>).
+#define HOSTED_SESSION_DEFAULT_FRAME_COUNT (600)
+
+// Frames the interactive session's rendering statistics get averaged over before being logged.
+#define RENDER_STATS_LOG_INTERVAL_FRAMES (600)
+
+// Longest time the main loop waits for input while the client is idle, so platform services like hotreloading keep getting updated.
+#define CLIENT_IDLE_WAIT_MAX_MS (1000)
+
+// Time the main loop sleeps for after each frame while no viewport window is visible, throttling frames when there is nothing to present.
+#define HIDDEN_VIEWPORTS_FRAME_SLEEP_MS (50)
+
+// Options the program was launched with, parsed from the command line.
+struct Win32LaunchOptions
 {
-	// Win32 Program Process instance.
-	HINSTANCE ProgramInstance = NULL;
+	// Path of the file each frame's input gets recorded into (-record-input <path>). No recording happens when empty.
+	std::string InputRecordingPath = "";
+
+	// Path of an input recording to feed the client instead of live input (-replay-input <path>). The program ends with the replay.
+	std::string InputReplayPath = "";
+
+	/*
+		Whether viewports should be created without windows (-headless). Their pixel buffers still get rendered into.
+		The interactive session can only be headless when replaying input, as nothing else could end it.
+	*/
+	bool bHeadless = false;
+
+	// Path of the file the draw calls of every viewport get captured into (-capture-draws <path>). No capture happens when empty.
+	std::string DrawCallCapturePath = "";
+
+	/*
+		Path of a draw call trace to replay through the rasterizer (-replay-draws <path>). When set, the program only replays the trace
+		and exits, without loading the client.
+	*/
+	std::string DrawCallReplayPath = "";
+
+	// Path of the file every rendered frame gets captured into (-capture-frames <path>). No capture happens when empty.
+	std::string FrameCapturePath = "";
+
+	/*
+		Prefix of the names of the shared memory each viewport's pixels get exported through (-export-framebuffers <prefix>), suffixed with
+		"_<viewport ID>", or "_<session index>_<viewport ID>" for hosted sessions. No export happens when empty.
+	*/
+	std::string FramebufferExportPrefix = "";
+
+	/*
+		Path of the file backing client persistent memory (-persistent-memory <path>). When set, persistent memory is mapped from that file so the
+		next launch can resume from it. Persistent memory is regular heap memory when empty.
+	*/
+	std::string PersistentMemoryPath = "";
+
+	// Render scale new viewports start with (-render-scale <scale>, between 0 and 1).
+	float RenderScale = 1.f;
+
+	/*
+		Fixed resolution every viewport gets rasterized at regardless of window size and render scale (-render-resolution <width>x<height>).
+		Unused when zero.
+	*/
+	uint16_t FixedRenderWidth = 0;
+	uint16_t FixedRenderHeight = 0;
+
+	/*
+		Count of client sessions to host side by side instead of running the interactive session (-sessions <count>). Hosted sessions are
+		always headless, run as fast as possible for HostedFrameCount frames (-frames <count>) and the program ends once all of them are done.
+		Unused when zero.
+	*/
+	uint32_t HostedSessionCount = 0;
+	uint32_t HostedFrameCount = HOSTED_SESSION_DEFAULT_FRAME_COUNT;
+
+	// Path of the asset pack mounted for the client (-asset-pack <path>). The default pack is only mounted if present.
+	std::string AssetPackPath = ASSET_PACK_DEFAULT_PATH;
+	bool bAssetPackPathGiven = false;
+
+	/*
+		Whether the client should run in a separate client host process (-isolate-client), so that a crashing client doesn't take the platform
+		down. Crashed or hung client hosts get restarted.
+	*/
+	bool bIsolateClient = false;
+
+	/*
+		Name of the shared memory linking this process to the platform process that launched it (-client-host <name>). When set, this process is a
+		client host: it only runs the client on behalf of the platform.
+	*/
+	std::string ClientHostName = "";
+};
 
-	// Whether the app is actively running client frames.
-	bool bRunning = false;
+/*
+	State of a single client session: the client's own data, the viewports it allocated and the buffers its frames use.
+	The interactive session lives in the App Context. Headless hosts (-sessions <count>) run many more side by side.
+*/
+struct Win32ClientSession
+{
+	// Index of the session. 0 for the interactive session, from 1 onwards for hosted sessions.
+	uint32_t Index = 0;
 
 	// Active Viewports
 	std::vector<Win32Viewport> Viewports;
@@ -69,14 +200,81 @@ struct Win32AppContext
 	ClientSessionData ClientRunningContext = {};
 	ClientFrameRequestData ClientFrameRequestData = {};
 
-	// Input buffer currently being filled in.
-	Win32ActionInputBuffer* InputBackbuffer = nullptr;
+	// Action Input buffer, filled in with input events at the start of each frame then read by the frame.
+	Win32ActionInputBuffer InputBuffer;
+
+	// Whether the client got started for this session, and whether its persistent memory is mapped from the persistent memory file.
+	bool bClientStarted = false;
+	bool bPersistentMemoryMapped = false;
+
+	// Whether the mapped persistent memory holds the state of a previous run, which the client gets resumed from instead of being started.
+	bool bPersistentMemoryResumed = false;
+
+	/*
+		Whether the client runs in the client host process rather than in this one. Its persistent memory and draw call buffers then live in the
+		client host's shared memory. Only ever set for the interactive session.
+	*/
+	bool bClientHosted = false;
+};
+
+// Global context state for the Win32 application layer.
+struct Win32AppContext
+{
+	// Win32 Program Process instance.
+	HINSTANCE ProgramInstance = NULL;
+
+	Win32LaunchOptions LaunchOptions;
 
-	// Input buffer currently in use by frame or about to be used by next frame.
-	Win32ActionInputBuffer* InputFrontbuffer = nullptr;
+	// Whether the app is actively running client frames.
+	bool bRunning = false;
+
+	// Interactive client session, fed with live or replayed input.
+	Win32ClientSession Session;
+
+	// Client host process running the interactive session's client, when isolating it.
+	Win32ClientHost ClientHost;
+
+	/*
+		Input thread, which owns every viewport window and runs their message loop independently of frames.
+		Its message-only window is used to have it create and destroy viewport windows on behalf of the main thread.
+	*/
+	HANDLE InputThread = NULL;
+	DWORD InputThreadID = 0;
+	HWND InputThreadWindow = NULL;
+
+	// Timestamped raw input records produced by the Input thread, consumed by the main thread at the start of each frame.
+	Win32InputQueue InputQueue;
+
+	/*
+		Auto-reset event signaled by the Input thread when it publishes records while the main thread waits for input, which it does
+		(setting bMainThreadWaitingForInput) for as long as the client is idle.
+	*/
+	HANDLE InputAvailableEvent = NULL;
+	std::atomic<bool> bMainThreadWaitingForInput{ false };
+
+	/*
+		Input thread only. Records that didn't fit in the Input Queue, pushed as soon as room is made so none are ever lost, and the last cursor move,
+		held back so bursts of cursor moves get coalesced into a single record.
+	*/
+	std::vector<Win32InputRecord> InputOverflowRecords;
+	Win32InputRecord PendingCursorMoveRecord = {};
+	bool bCursorMoveRecordPending = false;
+
+	// Rendering statistics of every viewport of the interactive session summed up since they were last logged, and the count of frames summed.
+	PlatformRenderStats RenderStatsTotals = {};
+	uint32_t RenderStatsFrameCount = 0;
+
+	// Input statistics, reported by the F8 info dump.
+	std::atomic<uint64_t> CoalescedCursorMoveCount{ 0 };
+	std::atomic<uint64_t> OverflowedInputRecordCount{ 0 };
+	uint64_t DroppedActionInputCount = 0;
+
+	// Timestamp of the start of the last frame. Input events are timed relative to the interval between it and the start of the next frame.
+	int64_t LastFrameStartTimestamp = 0;
 
 	// Latent input state, used to add extra data to input events.
 	Vector2s CursorCoordinates = {};
+	ViewportID CursorViewport = 0;
 	bool bCtrlPressed = false;
 	bool bShiftPressed = false;
 	bool bAltPressed = false;
@@ -85,40 +283,109 @@ struct Win32AppContext
 // Main Win32 Static Application Context.
 static Win32AppContext Win32App;
 
+/*
+	Session the calling thread runs frames for. Viewport management and draw call functions called by the client operate on it.
+	Points to the interactive session, unless the thread is running hosted sessions.
+*/
+static thread_local Win32ClientSession* CurrentSession = &Win32App.Session;
+
 // Main instance of loaded symbols from the Client dynamic library.
 static SynergyClientAPI Win32ClientAPI;
 
 bool ViewportIsValid(ViewportID ID)
 {
-	return Win32App.Viewports.size() > ID && Win32App.Viewports[ID].ID != VIEWPORT_ERROR_ID;
+	return CurrentSession->Viewports.size() > ID && CurrentSession->Viewports[ID].ID != VIEWPORT_ERROR_ID;
+}
+
+/*
+	Returns whether the viewport has anything to show, meaning it should be rasterized and presented. Headless viewports are always rendered
+	as long as they have a surface.
+*/
+bool ViewportIsVisible(const Win32Viewport& viewport)
+{
+	if (viewport.Surface.Pixels == nullptr)
+	{
+		return false;
+	}
+
+	return viewport.Win32WindowHandle == NULL
+		|| (!viewport.bMinimized && !viewport.bHidden && viewport.WindowWidth > 0 && viewport.WindowHeight > 0);
+}
+
+// Adds up the counters of Stats into Totals.
+void AccumulateRenderStats(PlatformRenderStats& Totals, const PlatformRenderStats& Stats)
+{
+	Totals.DrawCallCount += Stats.DrawCallCount;
+	for (uint32_t typeIndex = 0; typeIndex < PLATFORM_RENDER_STATS_DRAW_CALL_TYPE_CAPACITY; typeIndex++)
+	{
+		Totals.DrawCallCountPerType[typeIndex] += Stats.DrawCallCountPerType[typeIndex];
+	}
+	Totals.OffscreenDrawCallCount += Stats.OffscreenDrawCallCount;
+	Totals.RejectedDrawCallCount += Stats.RejectedDrawCallCount;
+	Totals.CulledDrawCallCount += Stats.CulledDrawCallCount;
+	Totals.DrawCallBufferBytesUsed += Stats.DrawCallBufferBytesUsed;
+	Totals.DrawCallBufferSize += Stats.DrawCallBufferSize;
+	Totals.PixelsWritten += Stats.PixelsWritten;
+}
+
+// Logs the end of a line with rendering statistics, each counter divided by FrameCount to log per frame averages.
+void LogRenderStats(const PlatformRenderStats& Stats, uint32_t FrameCount = 1)
+{
+	double divisor = (double)(max(FrameCount, 1u));
+	std::cout << (double)(Stats.DrawCallCount) / divisor << " draw calls ("
+		<< (double)(Stats.DrawCallCountPerType[(uint32_t)(DrawCallType::LINE)]) / divisor << " lines, "
+		<< (double)(Stats.DrawCallCountPerType[(uint32_t)(DrawCallType::RECTANGLE)]) / divisor << " rectangles, "
+		<< (double)(Stats.DrawCallCountPerType[(uint32_t)(DrawCallType::ELLIPSE)]) / divisor << " ellipses), "
+		<< (double)(Stats.CulledDrawCallCount) / divisor << " culled, " << (double)(Stats.OffscreenDrawCallCount) / divisor << " off-screen, "
+		<< (double)(Stats.RejectedDrawCallCount) / divisor << " rejected, "
+		<< (double)(Stats.DrawCallBufferBytesUsed) / divisor << " / " << (double)(Stats.DrawCallBufferSize) / divisor << " buffer bytes, "
+		<< (double)(Stats.PixelsWritten) / divisor << " pixels written.\n";
 }
 
 Win32Viewport* FindViewportFromWindowHandle(HWND windowHandle)
 {
-	// Simple linear search - we should never have too many viewports at once on this platform anyway.
-	for (ViewportID viewportID = 0; viewportID < Win32App.Viewports.size(); viewportID++)
+	/*
+		Viewport windows carry their Viewport ID in their user data slot (see InputThreadWindowProc()), making this a constant time lookup.
+		The handle is checked against the viewport's own so that windows without user data (which reads as ID 0) or belonging to a
+		destroyed viewport whose slot got reused are never mistaken for another viewport.
+	*/
+	ViewportID viewportID = (ViewportID)(GetWindowLongPtr(windowHandle, GWLP_USERDATA));
+	if (!ViewportIsValid(viewportID))
 	{
-		if (!ViewportIsValid(viewportID)) continue;
-		Win32Viewport& viewport = Win32App.Viewports[viewportID];
-		if (viewport.Win32WindowHandle == windowHandle)
-		{
-			return &viewport;
-		}
+		return nullptr;
 	}
-	return nullptr;
+
+	Win32Viewport& viewport = CurrentSession->Viewports[viewportID];
+	return viewport.Win32WindowHandle == windowHandle ? &viewport : nullptr;
 }
 
-/* Builds and records an action input for the given keyboard key code and viewport, putting it in whatever buffer(s) are appropriate. */
-void RecordActionInputForViewport(Win32Viewport& viewport, uint64_t Keycode, bool bRelease)
+/* 
+	Builds and records an action input for the given keyboard key code and viewport, putting it in whatever buffer(s) are appropriate.
+	TimeNormalized is the time at which the input happened relative to the last frame interval, between 0 and 1.
+*/
+void RecordActionInputForViewport(Win32Viewport& viewport, uint64_t Keycode, bool bRelease, float TimeNormalized)
 {
-	// Check that there is a backbuffer ready and that it is not full.
-	if (Win32App.InputBackbuffer == nullptr
-		|| Win32App.InputBackbuffer->EventCount >= Win32App.InputBackbuffer->MaxEventCount)
+	Win32ActionInputBuffer& inputBuffer = CurrentSession->InputBuffer;
+
+	// Grow the buffer if it is full. New slots are zeroed out as events expect to be written over zeroed memory.
+	if (inputBuffer.EventCount >= inputBuffer.MaxEventCount)
 	{
-		return;
+		size_t newMaxEventCount = max((size_t)(ACTION_INPUT_BUFFER_INITIAL_CAPACITY), inputBuffer.MaxEventCount * 2);
+		ActionInputEvent* newBuffer = (ActionInputEvent*)(realloc(inputBuffer.Buffer, newMaxEventCount * sizeof(ActionInputEvent)));
+
+		if (newBuffer == nullptr)
+		{
+			std::cerr << "ERROR: Failed to grow Action Input buffer to " << newMaxEventCount << " events. Dropping input.\n";
+			Win32App.DroppedActionInputCount++;
+			return;
+		}
+
+		memset(newBuffer + inputBuffer.MaxEventCount, 0, (newMaxEventCount - inputBuffer.MaxEventCount) * sizeof(ActionInputEvent));
+		inputBuffer.Buffer = newBuffer;
+		inputBuffer.MaxEventCount = newMaxEventCount;
 	}
 
-	ActionInputEvent& event = Win32App.InputBackbuffer->Buffer[Win32App.InputBackbuffer->EventCount];
+	ActionInputEvent& event = inputBuffer.Buffer[inputBuffer.EventCount];
 
 	// Determine keycode then fill in the input event.
 	ActionKey key = ActionKey::ACTION_KEY_NONE;
@@ -176,17 +443,36 @@ void RecordActionInputForViewport(Win32Viewport& viewport, uint64_t Keycode, boo
 	// First 6 function keys are reserved by the client.
 	if (key == ActionKey::KEY_FUNC7 && !bRelease)
 	{
-		// Force a hot reload of the client module if hot reloading is supported.
+		// Recompile the client module in the background and hotreload it once done, if hot reloading is supported.
 #if HOTRELOAD_SUPPORTED
-		RunHotreloadCompileProgram();
-		Win32_TryHotreloadClientModule(Win32ClientAPI, true);
+		Win32_StartHotreloadCompile();
 #endif
 	}
 	else if (key == ActionKey::KEY_FUNC8 && !bRelease)
 	{
 		// Log info about the current state of the platform.
 		std::cout << "WIN32 PLATFORM INFO:\n" <<
-			"\tMouse Coordinates: " << Win32App.CursorCoordinates.x << " | " << Win32App.CursorCoordinates.y << "\n";
+			"\tMouse Coordinates: " << Win32App.CursorCoordinates.x << " | " << Win32App.CursorCoordinates.y << "\n" <<
+			"\tCoalesced Cursor Moves: " << Win32App.CoalescedCursorMoveCount.load() << "\n" <<
+			"\tOverflowed Input Records: " << Win32App.OverflowedInputRecordCount.load() << "\n" <<
+			"\tDropped Action Inputs: " << Win32App.DroppedActionInputCount << "\n";
+
+		for (ViewportID viewportID = 0; viewportID < CurrentSession->Viewports.size(); viewportID++)
+		{
+			if (!ViewportIsValid(viewportID)) continue;
+			std::cout << "\tViewport " << viewportID << " Frame " << CurrentSession->Viewports[viewportID].RenderStats.FrameNumber << ": ";
+			LogRenderStats(CurrentSession->Viewports[viewportID].RenderStats);
+		}
+		Win32_LogAllocatorStats();
+	}
+	else if (key == ActionKey::KEY_FUNC9 && !bRelease)
+	{
+		// Cycle the render scale of the viewport through 1, 0.75 and 0.5.
+		viewport.RenderScale = viewport.RenderScale > 0.75f ? 0.75f : (viewport.RenderScale > 0.5f ? 0.5f : 1.f);
+		ResizeViewportSurface(viewport, viewport.WindowWidth, viewport.WindowHeight);
+
+		std::cout << "Viewport " << viewport.ID << " render scale set to " << viewport.RenderScale << ", rendering at "
+			<< viewport.Surface.Width << " x " << viewport.Surface.Height << ".\n";
 	}
 
 	// Determine modifier key states for this input.
@@ -197,165 +483,279 @@ void RecordActionInputForViewport(Win32Viewport& viewport, uint64_t Keycode, boo
 	// Fill in other properties.
 	event.key = key;
 	event.bRelease = bRelease;
-	event.timeNormalized = 0.f;
+	event.timeNormalized = TimeNormalized;
 	event.viewport = viewport.ID;
 	event.cursorLocation = Win32App.CursorCoordinates;
 
 	// Increment number of events in the buffer.
-	Win32App.InputBackbuffer->EventCount++;
+	inputBuffer.EventCount++;
 }
 
-LRESULT CALLBACK MainWindowProc(HWND window, UINT messageType, WPARAM wParam, LPARAM lParam)
+/*
+	Resizes the render surface of a viewport so it matches the passed window size, scaled down by its render scale or replaced by the fixed render
+	resolution if any. Surfaces come from a pool, so this only re-allocates when crossing size classes.
+*/
+void ResizeViewportSurface(Win32Viewport& viewport, int16_t newWidth, int16_t newHeight)
 {
-	BITMAPINFO bitmapInfo = {};
-	Win32Viewport* viewport = FindViewportFromWindowHandle(window);
+	// Update viewport window size and Surface. Leave Dimensions as is as it will keep being used by the client.
+	viewport.WindowWidth = (uint16_t)(max(newWidth, 0));
+	viewport.WindowHeight = (uint16_t)(max(newHeight, 0));
 
-	switch (messageType)
+	uint16_t renderWidth = (uint16_t)(viewport.WindowWidth * viewport.RenderScale + 0.5f);
+	uint16_t renderHeight = (uint16_t)(viewport.WindowHeight * viewport.RenderScale + 0.5f);
+
+	if (Win32App.LaunchOptions.FixedRenderWidth > 0 && Win32App.LaunchOptions.FixedRenderHeight > 0)
 	{
-	case(WM_CLOSE):
-		// Close the whole app on closing any viewport window.
-		Win32App.bRunning = false;
-		break;
-	case(WM_SIZE):
+		renderWidth = Win32App.LaunchOptions.FixedRenderWidth;
+		renderHeight = Win32App.LaunchOptions.FixedRenderHeight;
+	}
 
-		// Ignore message if window isn't tied to a viewport.
-		if (viewport == nullptr)
+	// Exported viewports render straight into their shared memory, which grows along with them.
+	if (viewport.FramebufferExport.Header != nullptr)
+	{
+		if (Win32_ResizeExportedPixelSurface(viewport.FramebufferExport, viewport.Surface, renderWidth, renderHeight))
 		{
-			break;
+			return;
 		}
 
-		// Do not do anything if Window got minimized.
-		if (wParam == SIZE_MINIMIZED)
+		std::cerr << "WARNING: Could not grow the exported framebuffer of viewport " << viewport.ID << " to " << renderWidth << " x " << renderHeight
+			<< ". Export paused until it fits again.\n";
+	}
+
+	Win32_ResizePixelSurface(viewport.Surface, renderWidth, renderHeight);
+}
+
+/*
+	Processes every input record pushed by the Input thread since the last frame, in order. Main thread only.
+	Input events get their time normalized over the interval between the start of the last frame and FrameStartTimestamp.
+*/
+void ProcessInputRecords(int64_t FrameStartTimestamp)
+{
+	int64_t frameInterval = FrameStartTimestamp - Win32App.LastFrameStartTimestamp;
+
+	Win32InputRecord record;
+	while (Win32App.InputQueue.Pop(record))
+	{
+		if (record.Type == Win32InputRecordType::CLOSE)
 		{
-			break;
+			// Close the whole app on closing any viewport window.
+			Win32App.bRunning = false;
+			continue;
 		}
 
-		// Re allocate render bitmap if size actually changed.
-		int16_t newWidth, newHeight;
-		newWidth = LOWORD(lParam);
-		newHeight = HIWORD(lParam);
+		// Ignore records from windows that aren't (or are no longer) tied to a viewport.
+		Win32Viewport* viewport = FindViewportFromWindowHandle(record.Window);
+		if (viewport == nullptr)
+		{
+			continue;
+		}
 
-		if (viewport->PixelBuffer != nullptr 
-			&& viewport->PixelBufferWidth == newWidth
-			&& viewport->PixelBufferHeight == newHeight)
+		switch (record.Type)
 		{
+		case(Win32InputRecordType::RESIZE):
+			// Keep the surface as is if Window got minimized, so nothing needs re-allocating when it gets restored.
+			viewport->bMinimized = record.SizeType == SIZE_MINIMIZED;
+			if (!viewport->bMinimized)
+			{
+				ResizeViewportSurface(*viewport, record.X, record.Y);
+			}
+			break;
+		case(Win32InputRecordType::VISIBILITY):
+			viewport->bHidden = record.X == 0;
+			break;
+		case(Win32InputRecordType::CURSOR_MOVE):
+			// Update cursor viewport and position.
+			Win32App.CursorCoordinates.x = record.X;
+			Win32App.CursorCoordinates.y = record.Y;
+			Win32App.CursorViewport = viewport->ID;
+			break;
+		case(Win32InputRecordType::KEY):
+			// Modifier keys are handled separately. 
+			if (record.Keycode == VK_CONTROL)
+			{
+				Win32App.bCtrlPressed = !record.bRelease;
+			}
+			else if (record.Keycode == VK_SHIFT)
+			{
+				Win32App.bShiftPressed = !record.bRelease;
+			}
+			// Alt is handled in a different message.
+			// All other keys go through the normal action input processing.
+			else
+			{
+				float timeNormalized = 0.f;
+				if (frameInterval > 0)
+				{
+					timeNormalized = (float)(record.Timestamp - Win32App.LastFrameStartTimestamp) / frameInterval;
+					timeNormalized = min(1.f, max(0.f, timeNormalized));
+				}
+
+				RecordActionInputForViewport(*viewport, record.Keycode, record.bRelease, timeNormalized);
+			}
+			break;
+		default:
 			break;
 		}
+	}
 
-		// Update viewport Buffer data. Leave Dimensions as is as it will keep being used by the client.
-		viewport->PixelBufferWidth = newWidth;
-		viewport->PixelBufferHeight = newHeight;
-		viewport->PixelBuffer = nullptr;
-			
-		// Init bitmap info for 32 bits RGBA format pixels.
-		bitmapInfo.bmiHeader.biSize = sizeof(bitmapInfo);
-		bitmapInfo.bmiHeader.biWidth = newWidth;
-		bitmapInfo.bmiHeader.biHeight = -newHeight; // Let's stick to upper-left origin.
-		bitmapInfo.bmiHeader.biPlanes = 1;
-		bitmapInfo.bmiHeader.biBitCount = 32;
-		bitmapInfo.bmiHeader.biCompression = BI_RGB;
+	Win32App.LastFrameStartTimestamp = FrameStartTimestamp;
+}
+
+// Input thread only. Wakes the main thread up if it is waiting for input. To be called after publishing records to the Input Queue.
+void WakeMainThreadForInput()
+{
+	// Full barrier so the published records are visible before checking the flag, pairing with the one in WaitForInput().
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (Win32App.bMainThreadWaitingForInput.load(std::memory_order_relaxed))
+	{
+		SetEvent(Win32App.InputAvailableEvent);
+	}
+}
+
+/*
+	Input thread only. Pushes as many overflowed records as possible to the Input Queue, in order.
+	Returns whether the overflow is now empty.
+*/
+bool FlushInputOverflowRecords()
+{
+	std::vector<Win32InputRecord>& overflow = Win32App.InputOverflowRecords;
+
+	size_t flushedCount = 0;
+	while (flushedCount < overflow.size() && Win32App.InputQueue.Push(overflow[flushedCount]))
+	{
+		flushedCount++;
+	}
+
+	overflow.erase(overflow.begin(), overflow.begin() + flushedCount);
+	if (flushedCount > 0)
+	{
+		WakeMainThreadForInput();
+	}
+
+	return overflow.empty();
+}
+
+// Input thread only. Pushes a record to the Input Queue, or to the overflow if the queue is full or records are already waiting in the overflow.
+void EnqueueInputRecord(const Win32InputRecord& Record)
+{
+	if (!FlushInputOverflowRecords() || !Win32App.InputQueue.Push(Record))
+	{
+		Win32App.InputOverflowRecords.push_back(Record);
+		Win32App.OverflowedInputRecordCount.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
 
-		// Create Device-Independent Bitmap section and link the viewport's buffer memory to it.
-		viewport->DrawingBitmap = CreateDIBSection(viewport->Win32WindowDC, &bitmapInfo,
-			DIB_RGB_COLORS, (void**)(&viewport->PixelBuffer), NULL, NULL);
+	WakeMainThreadForInput();
+}
+
+// Input thread only. Enqueues the held back cursor move record, if any.
+void FlushPendingCursorMoveRecord()
+{
+	if (Win32App.bCursorMoveRecordPending)
+	{
+		EnqueueInputRecord(Win32App.PendingCursorMoveRecord);
+		Win32App.bCursorMoveRecordPending = false;
+	}
+}
+
+/*
+	Input thread only. Timestamps the passed record and enqueues it.
+	Cursor moves are held back until another record comes in or the message queue runs dry, and replace any cursor move already held back.
+*/
+void PushInputRecord(Win32InputRecord& Record)
+{
+	LARGE_INTEGER timestamp;
+	QueryPerformanceCounter(&timestamp);
+	Record.Timestamp = timestamp.QuadPart;
 
-		if (viewport->DrawingBitmap == 0 || viewport->PixelBuffer == nullptr)
+	if (Record.Type == Win32InputRecordType::CURSOR_MOVE)
+	{
+		if (Win32App.bCursorMoveRecordPending)
 		{
-			std::cerr << "ERROR: Failed to allocate bitmap if size " << newWidth << " x " << newHeight << " !\n";
-			break;
+			Win32App.CoalescedCursorMoveCount.fetch_add(1, std::memory_order_relaxed);
 		}
-		
-		// Retrieve Bitmap DC to be used to copy the bitmap memory onto the viewport's window.
-		viewport->DrawingBitmapDC = CreateCompatibleDC(viewport->Win32WindowDC);
-		SelectObject(viewport->DrawingBitmapDC, viewport->DrawingBitmap);
 
+		Win32App.PendingCursorMoveRecord = Record;
+		Win32App.bCursorMoveRecordPending = true;
+		return;
+	}
+
+	// Keep records in order: the held back cursor move happened before this record.
+	FlushPendingCursorMoveRecord();
+	EnqueueInputRecord(Record);
+}
+
+// Input thread only. Pushes a key or mouse button transition record for the given window.
+void PushKeyInputRecord(HWND Window, uint64_t Keycode, bool bRelease)
+{
+	Win32InputRecord record = {};
+	record.Type = Win32InputRecordType::KEY;
+	record.Window = Window;
+	record.Keycode = Keycode;
+	record.bRelease = bRelease;
+
+	PushInputRecord(record);
+}
+
+/*
+	Window procedure of viewport windows, ran on the Input thread.
+	Relevant messages are turned into input records for the main thread to process. Viewport data must NOT be accessed from here.
+*/
+LRESULT CALLBACK MainWindowProc(HWND window, UINT messageType, WPARAM wParam, LPARAM lParam)
+{
+	Win32InputRecord record = {};
+	record.Window = window;
+
+	switch (messageType)
+	{
+	case(WM_CLOSE):
+		record.Type = Win32InputRecordType::CLOSE;
+		PushInputRecord(record);
+		break;
+	case(WM_SIZE):
+		record.Type = Win32InputRecordType::RESIZE;
+		record.SizeType = (uint8_t)(wParam);
+		record.X = LOWORD(lParam);
+		record.Y = HIWORD(lParam);
+		PushInputRecord(record);
+		break;
+	case(WM_SHOWWINDOW):
+		record.Type = Win32InputRecordType::VISIBILITY;
+		record.X = wParam ? 1 : 0;
+		PushInputRecord(record);
 		break;
 
 	// MOUSE INPUT
 	case(WM_MOUSEMOVE):
-		if (viewport != nullptr)
-		{
-			// Update cursor viewport and position.
-			Win32App.CursorCoordinates.x = LOWORD(lParam);
-			Win32App.CursorCoordinates.y = HIWORD(lParam);
-		}
+		record.Type = Win32InputRecordType::CURSOR_MOVE;
+		record.X = LOWORD(lParam);
+		record.Y = HIWORD(lParam);
+		PushInputRecord(record);
 		break;
 	case(WM_LBUTTONDOWN):
-		if (viewport != nullptr)
-		{
-			RecordActionInputForViewport(*viewport, VK_LBUTTON, false);
-		}
+		PushKeyInputRecord(window, VK_LBUTTON, false);
 		break;
 	case(WM_RBUTTONDOWN):
-		if (viewport != nullptr)
-		{
-			RecordActionInputForViewport(*viewport, VK_RBUTTON, false);
-		}
+		PushKeyInputRecord(window, VK_RBUTTON, false);
 		break;
 	case (WM_MBUTTONDOWN):
-		if (viewport != nullptr)
-		{
-			RecordActionInputForViewport(*viewport, VK_MBUTTON, false);
-		}
+		PushKeyInputRecord(window, VK_MBUTTON, false);
 		break;
 	case(WM_LBUTTONUP):
-		if (viewport != nullptr)
-		{
-			RecordActionInputForViewport(*viewport, VK_LBUTTON, true);
-		}
+		PushKeyInputRecord(window, VK_LBUTTON, true);
 		break;
 	case(WM_RBUTTONUP):
-		if (viewport != nullptr)
-		{
-			RecordActionInputForViewport(*viewport, VK_RBUTTON, true);
-		}
+		PushKeyInputRecord(window, VK_RBUTTON, true);
 		break;
 	case (WM_MBUTTONUP):
-		if (viewport != nullptr)
-		{
-			RecordActionInputForViewport(*viewport, VK_MBUTTON, true);
-		}
+		PushKeyInputRecord(window, VK_MBUTTON, true);
 		break;
 	// KEYBOARD INPUT
 	case(WM_KEYDOWN):
-		if (viewport != nullptr)
-		{
-			// Modifier keys are handled separately. 
-			if (wParam == VK_CONTROL)
-			{
-				Win32App.bCtrlPressed = true;
-			}
-			else if (wParam == VK_SHIFT)
-			{
-				Win32App.bShiftPressed = true;
-			}
-			// Alt is handled in a different message.
-			// All other keys go through the normal action input processing.
-			else
-			{
-				RecordActionInputForViewport(*viewport, wParam, false);
-			}
-		}
+		PushKeyInputRecord(window, wParam, false);
 		break;
 	case(WM_KEYUP):
-		if (viewport != nullptr)
-		{
-			// Modifier keys are handled separately. 
-			if (wParam == VK_CONTROL)
-			{
-				Win32App.bCtrlPressed = false;
-			}
-			else if (wParam == VK_SHIFT)
-			{
-				Win32App.bShiftPressed = false;
-			}
-			// Alt is handled in a different message.
-			// All other keys go through the normal action input processing.
-			else
-			{
-				RecordActionInputForViewport(*viewport, wParam, true);
-			}
-		}
+		PushKeyInputRecord(window, wParam, true);
 		break;
 	default:
 		break;
@@ -363,73 +763,251 @@ LRESULT CALLBACK MainWindowProc(HWND window, UINT messageType, WPARAM wParam, LP
 	return DefWindowProc(window, messageType, wParam, lParam);
 }
 
-// Cleans up resources associated with the Main Window. Closes it first if it wasn't closed already.
-void DestroyViewport(ViewportID ID)
+// Parameters for the creation of a viewport window by the Input thread.
+struct Win32ViewportWindowParams
 {
-	if (ViewportIsValid(ID))
+	ViewportID ID = VIEWPORT_ERROR_ID;
+	const WCHAR* Name = nullptr;
+	Vector2s Dimensions = {};
+};
+
+/*
+	Window procedure of the Input thread's message-only window. Creates and destroys viewport windows on request of the main thread, so that
+	they belong to the Input thread and get their messages pumped by it.
+*/
+LRESULT CALLBACK InputThreadWindowProc(HWND window, UINT messageType, WPARAM wParam, LPARAM lParam)
+{
+	switch (messageType)
+	{
+	case(WM_SYNERGY_CREATE_VIEWPORT_WINDOW):
 	{
-		Win32Viewport& viewport = Win32App.Viewports[ID];
+		Win32ViewportWindowParams& params = *(Win32ViewportWindowParams*)(lParam);
 
-		// If Win32 window exists for this viewport, close it.
-		if (viewport.Win32WindowHandle != nullptr)
-		{
-			CloseWindow(viewport.Win32WindowHandle);
-			viewport.Win32WindowHandle = nullptr;
-		}
+		HWND viewportWindow = CreateWindow(MAIN_WINDOW_CLASS_NAME, params.Name, WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT, 
+			params.Dimensions.x, params.Dimensions.y, NULL, NULL, Win32App.ProgramInstance, NULL);
 
-		// Free Viewport name if it is not using Error name.
-		if (viewport.Name != nullptr && lstrcmp(viewport.Name, Win32Viewport::ERROR_NAME) != 0)
+		if (viewportWindow == NULL)
 		{
-			free(viewport.Name);
-			viewport.Name = nullptr;
+			std::cerr << "Failed to create viewport window. Error Code = " << GetLastError() << "\n";
+			return 0;
 		}
 
-		// Free Draw Buffer.
-		if (viewport.ClientDrawCallBuffer.Buffer != nullptr)
-		{
-			free(viewport.ClientDrawCallBuffer.Buffer);
-			viewport.ClientDrawCallBuffer.Buffer = nullptr;
-		}
+		// Store Viewport ID in the window's user data for constant time lookup when processing its input records.
+		SetWindowLongPtr(viewportWindow, GWLP_USERDATA, (LONG_PTR)(params.ID));
 
-		// Free associated bitmap.
-		if (viewport.DrawingBitmap > 0)
-		{
-			DeleteObject(viewport.DrawingBitmap);
-			viewport.DrawingBitmap = NULL;
-			viewport.DrawingBitmapDC = NULL;
-		}
-		
-		// Reset viewport and give it the Error ID.
-		viewport = {};
-		viewport.ID = VIEWPORT_ERROR_ID;
+		// Show Window immediately.
+		ShowWindow(viewportWindow, 1);
+		return (LRESULT)(viewportWindow);
+	}
+	case(WM_SYNERGY_DESTROY_VIEWPORT_WINDOW):
+		DestroyWindow((HWND)(lParam));
+		return 0;
+	default:
+		break;
 	}
+	return DefWindowProc(window, messageType, wParam, lParam);
 }
 
-ViewportID AllocateViewport(const char* Name, Vector2s Dimensions)
+/*
+	Input thread entry point. Registers window classes, creates the thread's message-only window then pumps messages for every window
+	it owns until it receives WM_QUIT. Parameter is an event signaled once the thread is ready to create viewport windows.
+*/
+DWORD WINAPI InputThreadProc(LPVOID Parameter)
 {
-	static const LPCWSTR MAIN_WINDOW_CLASS_NAME = L"Synergy Main Window Class";
-	static bool MAIN_WINDOW_CLASS_REGISTERED = false;
+	HANDLE readyEvent = (HANDLE)(Parameter);
 
 	// Register Main Window Class
-	if (!MAIN_WINDOW_CLASS_REGISTERED)
-	{
-		WNDCLASS mainWindowClass = {};
+	WNDCLASS mainWindowClass = {};
 
-		mainWindowClass.hInstance = Win32App.ProgramInstance;
-		mainWindowClass.lpszClassName = MAIN_WINDOW_CLASS_NAME;
-		mainWindowClass.lpfnWndProc = MainWindowProc;
-		mainWindowClass.style = CS_OWNDC;
+	mainWindowClass.hInstance = Win32App.ProgramInstance;
+	mainWindowClass.lpszClassName = MAIN_WINDOW_CLASS_NAME;
+	mainWindowClass.lpfnWndProc = MainWindowProc;
+	mainWindowClass.style = CS_OWNDC;
 
-		RegisterClass(&mainWindowClass);
-		MAIN_WINDOW_CLASS_REGISTERED = true;
-	}
-	
-	// Find ID for viewport, allocate a new slot if necessary.
+	RegisterClass(&mainWindowClass);
+
+	// Register Input Thread Window Class and create its message-only window.
+	WNDCLASS inputThreadWindowClass = {};
+
+	inputThreadWindowClass.hInstance = Win32App.ProgramInstance;
+	inputThreadWindowClass.lpszClassName = INPUT_THREAD_WINDOW_CLASS_NAME;
+	inputThreadWindowClass.lpfnWndProc = InputThreadWindowProc;
+
+	RegisterClass(&inputThreadWindowClass);
+
+	Win32App.InputThreadWindow = CreateWindow(INPUT_THREAD_WINDOW_CLASS_NAME, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, Win32App.ProgramInstance, NULL);
+	SetEvent(readyEvent);
+
+	if (Win32App.InputThreadWindow == NULL)
+	{
+		return 1;
+	}
+
+	bool bQuit = false;
+	while (!bQuit)
+	{
+		MSG message;
+		while (PeekMessage(&message, NULL, NULL, NULL, PM_REMOVE))
+		{
+			if (message.message == WM_QUIT)
+			{
+				bQuit = true;
+				break;
+			}
+
+			TranslateMessage(&message);
+			DispatchMessage(&message);
+		}
+
+		// Message queue ran dry: publish the held back cursor move and as many overflowed records as the Input Queue can take.
+		FlushPendingCursorMoveRecord();
+		bool bOverflowPending = !FlushInputOverflowRecords();
+
+		// Sleep until new messages come in. While records are waiting in the overflow, wake up regularly to retry pushing them.
+		if (!bQuit)
+		{
+			MsgWaitForMultipleObjects(0, NULL, FALSE, bOverflowPending ? 1 : INFINITE, QS_ALLINPUT);
+		}
+	}
+
+	DestroyWindow(Win32App.InputThreadWindow);
+	Win32App.InputThreadWindow = NULL;
+	return 0;
+}
+
+// Allocates the Input Queue and starts the Input thread. Returns once the thread is ready to create viewport windows.
+bool StartInputThread()
+{
+	Win32App.InputQueue.Records = (Win32InputRecord*)(malloc(sizeof(Win32InputRecord) * WIN32_INPUT_QUEUE_CAPACITY));
+	Win32App.InputQueue.Capacity = WIN32_INPUT_QUEUE_CAPACITY;
+
+	if (Win32App.InputQueue.Records == nullptr)
+	{
+		std::cerr << "FATAL ERROR: Failed to allocate memory for the Input Queue !\n";
+		return false;
+	}
+
+	Win32App.InputAvailableEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+	HANDLE readyEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	Win32App.InputThread = CreateThread(NULL, 0, InputThreadProc, readyEvent, 0, &Win32App.InputThreadID);
+
+	if (Win32App.InputThread == NULL)
+	{
+		std::cerr << "FATAL ERROR: Failed to start Input thread. Error Code = " << GetLastError() << "\n";
+		CloseHandle(readyEvent);
+		return false;
+	}
+
+	WaitForSingleObject(readyEvent, INFINITE);
+	CloseHandle(readyEvent);
+
+	if (Win32App.InputThreadWindow == NULL)
+	{
+		std::cerr << "FATAL ERROR: Failed to create Input thread window. Error Code = " << GetLastError() << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+// Stops the Input thread, waiting for it to exit, and frees the Input Queue.
+void StopInputThread()
+{
+	if (Win32App.InputThread != NULL)
+	{
+		PostThreadMessage(Win32App.InputThreadID, WM_QUIT, 0, 0);
+		WaitForSingleObject(Win32App.InputThread, INFINITE);
+		CloseHandle(Win32App.InputThread);
+
+		Win32App.InputThread = NULL;
+		Win32App.InputThreadID = 0;
+	}
+
+	if (Win32App.InputAvailableEvent != NULL)
+	{
+		CloseHandle(Win32App.InputAvailableEvent);
+		Win32App.InputAvailableEvent = NULL;
+	}
+
+	if (Win32App.InputQueue.Records != nullptr)
+	{
+		free(Win32App.InputQueue.Records);
+		Win32App.InputQueue.Records = nullptr;
+		Win32App.InputQueue.Capacity = 0;
+	}
+}
+
+/*
+	Main thread only. Blocks until the Input thread publishes input records or TimeoutMilliseconds elapse, returning right away if records are
+	already waiting. Simply sleeps when there is no Input thread.
+*/
+void WaitForInput(DWORD TimeoutMilliseconds)
+{
+	if (Win32App.InputAvailableEvent == NULL)
+	{
+		Sleep(TimeoutMilliseconds);
+		return;
+	}
+
+	// Raise the flag before checking the queue, so that records published from now on wake us up.
+	Win32App.bMainThreadWaitingForInput.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (Win32App.InputQueue.IsEmpty())
+	{
+		WaitForSingleObject(Win32App.InputAvailableEvent, TimeoutMilliseconds);
+	}
+
+	Win32App.bMainThreadWaitingForInput.store(false, std::memory_order_relaxed);
+}
+
+// Cleans up resources associated with the Main Window. Closes it first if it wasn't closed already.
+void DestroyViewport(ViewportID ID)
+{
+	if (ViewportIsValid(ID))
+	{
+		Win32Viewport& viewport = CurrentSession->Viewports[ID];
+
+		// If Win32 window exists for this viewport, have the Input thread destroy it.
+		if (viewport.Win32WindowHandle != nullptr)
+		{
+			SendMessage(Win32App.InputThreadWindow, WM_SYNERGY_DESTROY_VIEWPORT_WINDOW, 0, (LPARAM)(viewport.Win32WindowHandle));
+			viewport.Win32WindowHandle = nullptr;
+		}
+
+		// Free Viewport name if it is not using Error name.
+		if (viewport.Name != nullptr && lstrcmp(viewport.Name, Win32Viewport::ERROR_NAME) != 0)
+		{
+			free(viewport.Name);
+			viewport.Name = nullptr;
+		}
+
+		// Free Draw Buffer, unless it lives in client host shared memory.
+		if (viewport.ClientDrawCallBuffer.Buffer != nullptr && !CurrentSession->bClientHosted)
+		{
+			free(viewport.ClientDrawCallBuffer.Buffer);
+		}
+		viewport.ClientDrawCallBuffer.Buffer = nullptr;
+
+		// Hand the render surface back to the pool, then close its export if any.
+		Win32_ReleasePixelSurface(viewport.Surface);
+		Win32_CloseFramebufferExport(viewport.FramebufferExport);
+		
+		// Reset viewport and give it the Error ID.
+		viewport = {};
+		viewport.ID = VIEWPORT_ERROR_ID;
+	}
+}
+
+ViewportID AllocateViewport(const char* Name, Vector2s Dimensions)
+{
+	// Find ID for viewport, allocate a new slot if necessary.
 	ViewportID newViewportID;
 	{
 		// Find an empty spot in the Viewports array or create a new one if none are available.
 		
-		for (newViewportID = 0; newViewportID < Win32App.Viewports.size(); newViewportID++)
+		for (newViewportID = 0; newViewportID < CurrentSession->Viewports.size(); newViewportID++)
 		{
 			if (!ViewportIsValid(newViewportID))
 			{
@@ -437,18 +1015,26 @@ ViewportID AllocateViewport(const char* Name, Vector2s Dimensions)
 			}
 		}
 
-		if (newViewportID == Win32App.Viewports.size())
+		// Hosted clients can only draw into viewports that have a draw call buffer in shared memory.
+		if (CurrentSession->bClientHosted && newViewportID >= CLIENT_HOST_MAX_VIEWPORTS)
+		{
+			std::cerr << "ERROR: Isolated clients can't have more than " << CLIENT_HOST_MAX_VIEWPORTS << " viewports.\n";
+			return VIEWPORT_ERROR_ID;
+		}
+
+		if (newViewportID == CurrentSession->Viewports.size())
 		{
 			// Failed to find available spot. Allocate new viewport slot. The ID should already correspond.
-			Win32App.Viewports.emplace_back();
+			CurrentSession->Viewports.emplace_back();
 		}
 	}
 
-	Win32Viewport& newViewport = Win32App.Viewports[newViewportID];
+	Win32Viewport& newViewport = CurrentSession->Viewports[newViewportID];
 	newViewport = {};
 	newViewport.ID = newViewportID;
 
 	newViewport.Dimensions = Dimensions;
+	newViewport.RenderScale = Win32App.LaunchOptions.RenderScale;
 
 	// Convert provided ANSI viewport name to UNICODE.
 	size_t nameLength = strlen(Name) + 1;
@@ -471,36 +1057,77 @@ ViewportID AllocateViewport(const char* Name, Vector2s Dimensions)
 		newViewport.Name = Win32Viewport::ERROR_NAME;
 	}
 
-	// Create Win32 Window.
-	newViewport.Win32WindowHandle = CreateWindow(MAIN_WINDOW_CLASS_NAME, newViewport.Name, WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT, Dimensions.x, Dimensions.y,
-		NULL, NULL, Win32App.ProgramInstance, NULL);
+	if (!Win32App.LaunchOptions.FramebufferExportPrefix.empty())
+	{
+		// Make room for the size the viewport renders at to start with: the fixed render resolution, or its dimensions. The export grows if it has to.
+		uint64_t exportWidth = (uint64_t)(max(Dimensions.x, (int16_t)(1)));
+		uint64_t exportHeight = (uint64_t)(max(Dimensions.y, (int16_t)(1)));
+		if (Win32App.LaunchOptions.FixedRenderWidth > 0 && Win32App.LaunchOptions.FixedRenderHeight > 0)
+		{
+			exportWidth = Win32App.LaunchOptions.FixedRenderWidth;
+			exportHeight = Win32App.LaunchOptions.FixedRenderHeight;
+		}
+		exportWidth = (exportWidth + WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT - 1) / WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT * WIN32_PIXEL_SURFACE_STRIDE_ALIGNMENT;
+
+		// Hosted sessions have their index in the name too, as viewport IDs are only unique within a session.
+		std::string exportName = Win32App.LaunchOptions.FramebufferExportPrefix + "_";
+		if (CurrentSession->Index > 0)
+		{
+			exportName += std::to_string(CurrentSession->Index) + "_";
+		}
+		exportName += std::to_string(newViewport.ID);
+		Win32_OpenFramebufferExport(newViewport.FramebufferExport, exportName, exportWidth * exportHeight * sizeof(Win32PixelRGBA));
+	}
 
-	if (newViewport.Win32WindowHandle == NULL)
+	if (Win32App.LaunchOptions.bHeadless)
 	{
-		std::cerr << "Failed to create viewport window. Error Code = " << GetLastError() << "\n";
-		DestroyViewport(newViewport.ID);
-		return VIEWPORT_ERROR_ID;
+		// Headless viewports have no window to be sized by, so give them a pixel buffer matching their dimensions right away.
+		ResizeViewportSurface(newViewport, Dimensions.x, Dimensions.y);
 	}
+	else
+	{
+		// Have the Input thread create and show the Win32 Window, so its messages keep being processed independently of frames.
+		Win32ViewportWindowParams windowParams = {};
+		windowParams.ID = newViewport.ID;
+		windowParams.Name = newViewport.Name;
+		windowParams.Dimensions = Dimensions;
+
+		newViewport.Win32WindowHandle = (HWND)(SendMessage(Win32App.InputThreadWindow, WM_SYNERGY_CREATE_VIEWPORT_WINDOW, 0, (LPARAM)(&windowParams)));
+
+		if (newViewport.Win32WindowHandle == NULL)
+		{
+			DestroyViewport(newViewport.ID);
+			return VIEWPORT_ERROR_ID;
+		}
+
+		// Cache Window Device Context. Rendered surfaces get blitted onto it.
+		newViewport.Win32WindowDC = GetDC(newViewport.Win32WindowHandle);
 
-	// Cache Window Device Context. It will be used to tie Bitmaps created on Size events to the window.
-	newViewport.Win32WindowDC = GetDC(newViewport.Win32WindowHandle);
+		// Surfaces rendered at a lower resolution get stretched with nearest neighbour filtering, which is the cheapest.
+		SetStretchBltMode(newViewport.Win32WindowDC, COLORONCOLOR);
+	}
 
-	// Allocate Frame Buffer for the viewport.
+	// Allocate Frame Buffer for the viewport. Hosted clients write draw calls straight into shared memory.
 	Win32DrawCallBuffer frameDrawBuffer = Win32DrawCallBuffer();
-	frameDrawBuffer.Buffer = (uint8_t*)(malloc(64000));
-	frameDrawBuffer.BufferSize = 64000;
+	frameDrawBuffer.Buffer = CurrentSession->bClientHosted ? Win32_GetClientHostDrawCallBuffer(Win32App.ClientHost, (uint32_t)(newViewport.ID))
+		: (uint8_t*)(malloc(WIN32_DRAW_CALL_BUFFER_SIZE));
+	frameDrawBuffer.BufferSize = WIN32_DRAW_CALL_BUFFER_SIZE;
 
 	newViewport.ClientDrawCallBuffer = frameDrawBuffer;
 
-	// Show Window immediately and return the viewport ID.
-	ShowWindow(newViewport.Win32WindowHandle, 1);
 	return newViewport.ID;
 }
 
-// Allocates a Windows console and redirects Standard Out and Standard Error to it.
-void CreateConsole()
+/*
+	Allocates a Windows console and redirects Standard Out and Standard Error to it.
+	When bAttachToParent is set, the console of the parent process gets used instead if it has one.
+*/
+void CreateConsole(bool bAttachToParent = false)
 {
-	AllocConsole();
+	if (!bAttachToParent || !AttachConsole(ATTACH_PARENT_PROCESS))
+	{
+		AllocConsole();
+	}
 	
 	// Redirect standard out to allocated console.
 	FILE* fDummy;
@@ -516,74 +1143,207 @@ void CloseConsole()
 	FreeConsole();
 }
 
-// Runs necessary post-init checks to ensure initialization was successful and the app is in a state where it can run.
-bool AppContextInitSuccessful()
+// Parses the program's command line into launch options. Unknown arguments are reported and ignored.
+Win32LaunchOptions ParseLaunchOptions(const char* CommandLine)
 {
-	return Win32ClientAPI.APISuccessfullyLoaded();
-}
+	// Split command line into arguments, separated by whitespace unless quoted.
+	std::vector<std::string> arguments;
+	std::string argument;
+	bool bInQuotes = false;
+	bool bArgumentStarted = false;
 
-/*
-	Final program cleanup code ran when the program ends for ANY reason.
-	When Force Shutdown is true, a lot of "heavy" or thread-sensitive cleanup operations will be skipped, the priority being to free
-	external resources, cleanup temporary files and exit before the OS timeout forces us to.
-*/
-void OnProgramEnd()
-{
-	// Deallocate client frame memory
-	if (Win32App.ClientFrameRequestData.FrameMemoryBuffer.Memory != nullptr)
+	for (const char* character = CommandLine; character != nullptr && *character != '\0'; character++)
 	{
-		free(Win32App.ClientFrameRequestData.FrameMemoryBuffer.Memory);
-		Win32App.ClientFrameRequestData.FrameMemoryBuffer.Memory = nullptr;
-		Win32App.ClientFrameRequestData.FrameMemoryBuffer.Size = 0;
+		if (*character == '"')
+		{
+			bInQuotes = !bInQuotes;
+			bArgumentStarted = true;
+		}
+		else if ((*character == ' ' || *character == '\t') && !bInQuotes)
+		{
+			if (bArgumentStarted)
+			{
+				arguments.push_back(argument);
+				argument.clear();
+				bArgumentStarted = false;
+			}
+		}
+		else
+		{
+			argument += *character;
+			bArgumentStarted = true;
+		}
 	}
 
-	// Deallocate client persistent memory
-	if (Win32App.ClientRunningContext.PersistentMemoryBuffer.Memory != nullptr)
+	if (bArgumentStarted)
 	{
-		free(Win32App.ClientRunningContext.PersistentMemoryBuffer.Memory);
-		Win32App.ClientRunningContext.PersistentMemoryBuffer.Memory = nullptr;
-		Win32App.ClientRunningContext.PersistentMemoryBuffer.Size = 0;
+		arguments.push_back(argument);
 	}
 
-	// If Client API was ever successfully loaded, unload it.
-	if (Win32ClientAPI.APISuccessfullyLoaded())
+	// Interpret arguments.
+	Win32LaunchOptions options = {};
+	for (size_t argumentIndex = 0; argumentIndex < arguments.size(); argumentIndex++)
 	{
-		Win32ClientAPI.ShutdownClient(Win32App.ClientRunningContext);
-		
-		Win32_UnloadClientModule(Win32ClientAPI);
+		const std::string& option = arguments[argumentIndex];
+		bool bHasValue = argumentIndex + 1 < arguments.size();
+
+		if (option == "-record-input" && bHasValue)
+		{
+			options.InputRecordingPath = arguments[++argumentIndex];
+		}
+		else if (option == "-replay-input" && bHasValue)
+		{
+			options.InputReplayPath = arguments[++argumentIndex];
+		}
+		else if (option == "-headless")
+		{
+			options.bHeadless = true;
+		}
+		else if (option == "-capture-draws" && bHasValue)
+		{
+			options.DrawCallCapturePath = arguments[++argumentIndex];
+		}
+		else if (option == "-replay-draws" && bHasValue)
+		{
+			options.DrawCallReplayPath = arguments[++argumentIndex];
+		}
+		else if (option == "-capture-frames" && bHasValue)
+		{
+			options.FrameCapturePath = arguments[++argumentIndex];
+		}
+		else if (option == "-export-framebuffers" && bHasValue)
+		{
+			options.FramebufferExportPrefix = arguments[++argumentIndex];
+		}
+		else if (option == "-persistent-memory" && bHasValue)
+		{
+			options.PersistentMemoryPath = arguments[++argumentIndex];
+		}
+		else if (option == "-render-scale" && bHasValue)
+		{
+			float renderScale = strtof(arguments[++argumentIndex].c_str(), nullptr);
+			if (renderScale > 0.f && renderScale <= 1.f)
+			{
+				options.RenderScale = renderScale;
+			}
+			else
+			{
+				std::cerr << "WARNING: Ignoring render scale \"" << arguments[argumentIndex] << "\", which should be between 0 and 1.\n";
+			}
+		}
+		else if (option == "-render-resolution" && bHasValue)
+		{
+			unsigned int renderWidth = 0, renderHeight = 0;
+			if (sscanf_s(arguments[++argumentIndex].c_str(), "%ux%u", &renderWidth, &renderHeight) == 2
+				&& renderWidth > 0 && renderWidth <= INT16_MAX && renderHeight > 0 && renderHeight <= INT16_MAX)
+			{
+				options.FixedRenderWidth = (uint16_t)(renderWidth);
+				options.FixedRenderHeight = (uint16_t)(renderHeight);
+			}
+			else
+			{
+				std::cerr << "WARNING: Ignoring render resolution \"" << arguments[argumentIndex] << "\", which should be formatted as <width>x<height>.\n";
+			}
+		}
+		else if (option == "-asset-pack" && bHasValue)
+		{
+			options.AssetPackPath = arguments[++argumentIndex];
+			options.bAssetPackPathGiven = true;
+		}
+		else if (option == "-isolate-client")
+		{
+			options.bIsolateClient = true;
+		}
+		else if (option == "-client-host" && bHasValue)
+		{
+			options.ClientHostName = arguments[++argumentIndex];
+		}
+		else if (option == "-sessions" && bHasValue)
+		{
+			unsigned long sessionCount = strtoul(arguments[++argumentIndex].c_str(), nullptr, 10);
+			if (sessionCount > 0 && sessionCount <= UINT16_MAX)
+			{
+				options.HostedSessionCount = (uint32_t)(sessionCount);
+			}
+			else
+			{
+				std::cerr << "WARNING: Ignoring session count \"" << arguments[argumentIndex] << "\", which should be a positive number.\n";
+			}
+		}
+		else if (option == "-frames" && bHasValue)
+		{
+			unsigned long frameCount = strtoul(arguments[++argumentIndex].c_str(), nullptr, 10);
+			if (frameCount > 0 && frameCount <= UINT32_MAX)
+			{
+				options.HostedFrameCount = (uint32_t)(frameCount);
+			}
+			else
+			{
+				std::cerr << "WARNING: Ignoring frame count \"" << arguments[argumentIndex] << "\", which should be a positive number.\n";
+			}
+		}
+		else
+		{
+			std::cerr << "WARNING: Ignoring unknown or incomplete command line argument \"" << option << "\".\n";
+		}
 	}
 
-	// Destroy remaining viewports.
-	for (ViewportID viewportID = 0; viewportID < Win32App.Viewports.size(); viewportID++)
+	// Hosted sessions never get windows, and run the client library in process.
+	if (options.HostedSessionCount > 0)
 	{
-		if (!ViewportIsValid(viewportID)) continue;
-		Win32Viewport& viewport = Win32App.Viewports[viewportID];
+		options.bHeadless = true;
+		options.bIsolateClient = false;
+	}
+
+	// Interactive headless sessions have no window to close and no live input, so only the end of an input replay can end them.
+	if (options.bHeadless && options.HostedSessionCount == 0 && options.InputReplayPath.empty())
+	{
+		std::cerr << "WARNING: Ignoring -headless, which needs -replay-input unless hosting sessions (-sessions <count>).\n";
+		options.bHeadless = false;
+	}
 
-		DestroyViewport(viewport.ID);
+	// Isolated clients keep their persistent memory in client host shared memory instead.
+	if (options.bIsolateClient && !options.PersistentMemoryPath.empty())
+	{
+		std::cerr << "WARNING: Ignoring persistent memory file, which can't be used by isolated clients.\n";
+		options.PersistentMemoryPath.clear();
 	}
 
-	Win32_CleanupHotreloadFiles();
+	return options;
+}
 
-	if (DEBUG_CONSOLE)
+// Loads the client library. If HOT RELOAD is supported, first try to use that instead of loading whatever is inside the executable directory itself.
+void LoadClientModule()
+{
+#if HOTRELOAD_SUPPORTED
+	Win32_TryHotreloadClientModule(Win32ClientAPI);
+	if (!Win32ClientAPI.APISuccessfullyLoaded())
 	{
-		system("pause");
-		CloseConsole();
+		std::cerr << "Failed to load Client library from Client Source folder. Attempting to load client library from executable folder...\n";
+		Win32_LoadClientModule(Win32ClientAPI);
 	}
+#else
+	Win32_LoadClientModule(Win32ClientAPI);
+#endif
 }
 
 /*
-	Returns a valid Client Session Data structure which can be used to start and run a Client with.
+	Mounts the asset pack given on the command line, or the default one if present. Missing packs are only reported when one was given, as clients
+	don't have to use any.
 */
-ClientSessionData InitializeClientSessionData(size_t PersistentMemorySize)
+void MountAssetPack()
 {
-	ClientSessionData sessionData = {};
-	sessionData.PersistentMemoryBuffer.Memory = (uint8_t*)(malloc(PersistentMemorySize));
-	sessionData.PersistentMemoryBuffer.Size = PersistentMemorySize;
+	const Win32LaunchOptions& options = Win32App.LaunchOptions;
+	if (options.bAssetPackPathGiven || GetFileAttributesA(options.AssetPackPath.c_str()) != INVALID_FILE_ATTRIBUTES)
+	{
+		Win32_MountAssetPack(options.AssetPackPath);
+	}
+}
 
-	sessionData.Platform.AllocateViewport = AllocateViewport;
-	sessionData.Platform.DestroyViewport = DestroyViewport;
-	
-	return sessionData;
+// Runs necessary post-init checks to ensure initialization was successful and the app is in a state where it can run.
+bool AppContextInitSuccessful()
+{
+	return Win32ClientAPI.APISuccessfullyLoaded();
 }
 
 /*
@@ -610,16 +1370,16 @@ ClientFrameRequestData InitializeFrameRequestData(size_t FrameNumber, size_t Fra
 	frameData.NewDrawCall = [](ViewportID TargetViewportID, DrawCallType Type)
 		{
 			// Simply redirect the call directly to whichever draw buffer is assigned to the target viewport.
-			return Win32App.Viewports[TargetViewportID].ClientDrawCallBuffer.NewDrawCall(Type);
+			return CurrentSession->Viewports[TargetViewportID].ClientDrawCallBuffer.NewDrawCall(Type);
 		};
 
 	// Note cursor location & viewport ID as the frame is about to start.
 	frameData.CursorLocation = Win32App.CursorCoordinates;
-	frameData.CursorViewport = 0;
+	frameData.CursorViewport = Win32App.CursorViewport;
 
 	// Assign input buffer.
-	frameData.ActionInputEvents.Buffer = Win32App.InputFrontbuffer->Buffer;
-	frameData.ActionInputEvents.EventCount = Win32App.InputFrontbuffer->EventCount;
+	frameData.ActionInputEvents.Buffer = CurrentSession->InputBuffer.Buffer;
+	frameData.ActionInputEvents.EventCount = CurrentSession->InputBuffer.EventCount;
 
 	return frameData;
 }
@@ -635,149 +1395,867 @@ void FreeFrameRequestData(ClientFrameRequestData& FrameData)
 	FrameData = {};
 }
 
-int WINAPI WinMain(_In_ HINSTANCE hInstance,
-	_In_opt_ HINSTANCE hPrevInstance,
-	_In_ LPSTR lpCmdLine,
-	_In_ int nShowCmd)
+/*
+	Prepares the current session's Client Session Data and input buffer so a Client can be started and run with them.
+	Only the interactive session has its persistent memory mapped from the persistent memory file, if requested.
+*/
+void InitializeClientSession(size_t PersistentMemorySize)
 {
-	Win32App.ProgramInstance = hInstance;
-
-	if (DEBUG_CONSOLE)
+	ClientSessionData& sessionData = CurrentSession->ClientRunningContext;
+	sessionData = {};
+
+	/*
+		Hosted clients keep their persistent memory in client host shared memory, which the platform owns so it needs no copying between processes.
+		It doesn't outlive a crash: restarting the client host zeroes it, as the crashed client may have left it inconsistent.
+	*/
+	if (CurrentSession->bClientHosted)
 	{
-		CreateConsole();
+		sessionData.PersistentMemoryBuffer.Memory = Win32_GetClientHostPersistentMemory(Win32App.ClientHost);
 	}
-
-	// Reset Temp folder which serves as a staging area for all files that are only relevant while the program runs.
-	Win32_ResetTempDataFolder();
-
-	// If HOT RELOAD is supported, then first try to use that instead of loading whatever is inside the executable directory itself.
-#if HOTRELOAD_SUPPORTED
-	Win32_TryHotreloadClientModule(Win32ClientAPI);
-	if (!Win32ClientAPI.APISuccessfullyLoaded())
+	// Map persistent memory from its backing file if requested, so state from the previous session is resumed in place.
+	else if (!Win32App.LaunchOptions.PersistentMemoryPath.empty() && CurrentSession->Index == 0)
 	{
-		std::cerr << "Failed to load Client library from Client Source folder. Attempting to load client library from executable folder...\n";
-		Win32_LoadClientModule(Win32ClientAPI);
+		bool bResumed = false;
+		sessionData.PersistentMemoryBuffer.Memory = (uint8_t*)(Win32_MapPersistentMemoryFile(Win32App.LaunchOptions.PersistentMemoryPath,
+			PersistentMemorySize, Win32_GetClientPersistentMemoryLayoutVersion(), bResumed));
+
+		if (sessionData.PersistentMemoryBuffer.Memory == nullptr)
+		{
+			std::cerr << "WARNING: Falling back to non-persistent memory for the client.\n";
+		}
+		CurrentSession->bPersistentMemoryMapped = sessionData.PersistentMemoryBuffer.Memory != nullptr;
+		CurrentSession->bPersistentMemoryResumed = CurrentSession->bPersistentMemoryMapped && bResumed;
 	}
-#else
-	Win32_LoadClientModule(Win32ClientAPI);
-#endif
 
-	if (!AppContextInitSuccessful())
+	if (sessionData.PersistentMemoryBuffer.Memory == nullptr)
 	{
-		std::cerr << "FATAL ERROR: Platform initialization failed ! Ending program.\n";
-		OnProgramEnd();
-		return 1;
+		sessionData.PersistentMemoryBuffer.Memory = (uint8_t*)(malloc(PersistentMemorySize));
 	}
+	sessionData.PersistentMemoryBuffer.Size = PersistentMemorySize;
 
-	// Initialize Client Context & Run Client Start, if the app initialized successfully.
-	Win32App.ClientRunningContext = InitializeClientSessionData(1024 * 68); // 68kB Persistent memory
+	sessionData.Platform.AllocateViewport = AllocateViewport;
+	sessionData.Platform.DestroyViewport = DestroyViewport;
 
-	// Start the client
-	Win32ClientAPI.StartClient(Win32App.ClientRunningContext);
+	// Input buffer. Starts out with a reasonable capacity, grows on demand.
+	Win32ActionInputBuffer& inputBuffer = CurrentSession->InputBuffer;
+	inputBuffer.Buffer = (ActionInputEvent*)(calloc(ACTION_INPUT_BUFFER_INITIAL_CAPACITY, sizeof(ActionInputEvent)));
+	inputBuffer.EventCount = 0;
+	inputBuffer.MaxEventCount = inputBuffer.Buffer != nullptr ? ACTION_INPUT_BUFFER_INITIAL_CAPACITY : 0;
+}
+
+/*
+	Shuts the current session's client down if it got started, destroys its viewports and frees every resource it holds.
+*/
+void EndClientSession()
+{
+	Win32ClientSession& session = *CurrentSession;
+
+	if (session.bClientHosted)
+	{
+		// Have the client host shut the client down and exit. Viewport draw call buffers go away with its shared memory.
+		Win32_StopClientHost(Win32App.ClientHost, session.ClientRunningContext);
+	}
+	else if (session.bClientStarted && Win32ClientAPI.APISuccessfullyLoaded())
+	{
+		Win32ClientAPI.ShutdownClient(session.ClientRunningContext);
+	}
+	session.bClientStarted = false;
+
+	// Destroy remaining viewports.
+	for (ViewportID viewportID = 0; viewportID < session.Viewports.size(); viewportID++)
+	{
+		if (!ViewportIsValid(viewportID)) continue;
+		DestroyViewport(viewportID);
+	}
+
+	// Deallocate client frame memory
+	if (session.ClientFrameRequestData.FrameMemoryBuffer.Memory != nullptr)
+	{
+		FreeFrameRequestData(session.ClientFrameRequestData);
+	}
+
+	// Deallocate input buffer
+	if (session.InputBuffer.Buffer != nullptr)
+	{
+		free(session.InputBuffer.Buffer);
+		session.InputBuffer = {};
+	}
+
+	// Deallocate client persistent memory, or unmap it if it is backed by a file. Shared memory went with the client host.
+	if (session.bPersistentMemoryMapped)
+	{
+		Win32_UnmapPersistentMemoryFile();
+		session.bPersistentMemoryMapped = false;
+		session.bPersistentMemoryResumed = false;
+	}
+	else if (session.ClientRunningContext.PersistentMemoryBuffer.Memory != nullptr && !session.bClientHosted)
+	{
+		free(session.ClientRunningContext.PersistentMemoryBuffer.Memory);
+	}
+	session.ClientRunningContext.PersistentMemoryBuffer.Memory = nullptr;
+	session.ClientRunningContext.PersistentMemoryBuffer.Size = 0;
+	session.bClientHosted = false;
+}
+
+/*
+	Starts the interactive session's client, in the client host process if it is hosted. Clients whose persistent memory got resumed from the
+	persistent memory file get resumed instead, provided they export "ResumeClient". Others are started from blank persistent memory.
+	Returns false if the client host crashed or hung while starting the client.
+*/
+bool StartSessionClient()
+{
+	Win32ClientSession& session = Win32App.Session;
+
+	if (session.bClientHosted)
+	{
+		session.bClientStarted = Win32_RunClientHostStart(Win32App.ClientHost, session.ClientRunningContext);
+	}
+	else if (session.bPersistentMemoryResumed && Win32_ResumeClient(session.ClientRunningContext))
+	{
+		std::cout << "Client resumed from its persistent memory.\n";
+		session.bClientStarted = true;
+	}
+	else
+	{
+		if (session.bPersistentMemoryResumed)
+		{
+			// Starting the client over resumed state would have it rebuild or overwrite that state, so hand it blank memory as on a first run.
+			std::cerr << "WARNING: Client library doesn't export \"ResumeClient\". Starting the client from blank persistent memory.\n";
+			memset(session.ClientRunningContext.PersistentMemoryBuffer.Memory, 0, session.ClientRunningContext.PersistentMemoryBuffer.Size);
+			session.bPersistentMemoryResumed = false;
+		}
+
+		Win32ClientAPI.StartClient(session.ClientRunningContext);
+		session.bClientStarted = true;
+	}
+
+	return session.bClientStarted;
+}
+
+/*
+	Runs a frame of the interactive session's client with its current frame data, in the client host process if it is hosted.
+	Returns false if the client host crashed or hung during the frame.
+*/
+bool RunSessionClientFrame()
+{
+	Win32ClientSession& session = Win32App.Session;
+
+	if (session.bClientHosted)
+	{
+		return Win32_RunClientHostFrame(Win32App.ClientHost, session.ClientRunningContext, session.ClientFrameRequestData);
+	}
+
+	Win32ClientAPI.RunClientFrame(session.ClientRunningContext, session.ClientFrameRequestData);
+	return true;
+}
+
+/*
+	Replaces a crashed or hung client host with a new one and starts the client again from scratch. Viewports of the previous client get destroyed.
+	Returns whether the client could be started again.
+*/
+bool RestartSessionClientHost()
+{
+	Win32ClientSession& session = Win32App.Session;
+	session.bClientStarted = false;
+
+	for (ViewportID viewportID = 0; viewportID < session.Viewports.size(); viewportID++)
+	{
+		if (!ViewportIsValid(viewportID)) continue;
+		DestroyViewport(viewportID);
+	}
+
+	std::cout << "Restarting client host process.\n";
+	return Win32_RestartClientHost(Win32App.ClientHost) && StartSessionClient();
+}
+
+/*
+	Puts the draw call buffers of every viewport of the current session in write mode, before running a frame. Draw calls falling entirely
+	outside of their viewport's window get culled once the frame ran, wherever the client runs.
+*/
+void BeginSessionFrameDrawing()
+{
+	for (ViewportID viewportID = 0; viewportID < CurrentSession->Viewports.size(); viewportID++)
+	{
+		if (!ViewportIsValid(viewportID)) continue;
+		Win32Viewport& viewport = CurrentSession->Viewports[viewportID];
+
+		viewport.ClientDrawCallBuffer.CullWidth = viewport.WindowWidth;
+		viewport.ClientDrawCallBuffer.CullHeight = viewport.WindowHeight;
+		if (CurrentSession->bClientHosted)
+		{
+			Win32_SetClientHostCullSize(Win32App.ClientHost, (uint32_t)(viewportID), viewport.WindowWidth, viewport.WindowHeight);
+		}
+
+		if (!viewport.ClientDrawCallBuffer.BeginWrite())
+		{
+			// If the buffer can't be written into for any reason, unlink Draw Call function.
+			// This will effectively disable drawing for this frame.
+			std::cerr << "ERROR: Could not set draw buffer to write mode for frame " << CurrentSession->ClientFrameRequestData.FrameNumber << "\n";
+			CurrentSession->ClientFrameRequestData.NewDrawCall = nullptr;
+		}
+	}
+}
+
+/*
+	Takes the draw call buffers of every viewport of the current session out of write mode once the frame ran, culling their draw calls.
+	Buffers a client host wrote into get what it kept track of while writing instead.
+*/
+void EndSessionFrameDrawing()
+{
+	for (ViewportID viewportID = 0; viewportID < CurrentSession->Viewports.size(); viewportID++)
+	{
+		if (!ViewportIsValid(viewportID)) continue;
+		Win32DrawCallBuffer& drawCallBuffer = CurrentSession->Viewports[viewportID].ClientDrawCallBuffer;
+
+		if (CurrentSession->bClientHosted)
+		{
+			Win32_SyncClientHostDrawCallBuffer(Win32App.ClientHost, (uint32_t)(viewportID), drawCallBuffer);
+		}
+		else
+		{
+			drawCallBuffer.EndWrite();
+		}
+	}
+}
+
+// Rasterizes the draw calls of every visible viewport of the current session into its surface, after clearing it to black.
+void RasterizeSessionViewports()
+{
+	for (ViewportID viewportID = 0; viewportID < CurrentSession->Viewports.size(); viewportID++)
+	{
+		if (!ViewportIsValid(viewportID)) continue;
+		Win32Viewport& viewport = CurrentSession->Viewports[viewportID];
+
+		PlatformRenderStats& stats = viewport.RenderStats;
+		stats = {};
+		stats.FrameNumber = CurrentSession->ClientFrameRequestData.FrameNumber;
+		stats.DrawCallBufferSize = viewport.ClientDrawCallBuffer.BufferSize;
+		stats.RejectedDrawCallCount = viewport.ClientDrawCallBuffer.RejectedDrawCallCount;
+		stats.CulledDrawCallCount = viewport.ClientDrawCallBuffer.CulledDrawCallCount;
+
+		if (!ViewportIsVisible(viewport)) continue;
+
+		Win32_BeginExportedFrame(viewport.FramebufferExport);
+
+		// Clear screen to blue.
+		Win32_ClearPixelSurface(0xFF000000, viewport.Surface);
+		
+		if (!viewport.ClientDrawCallBuffer.BeginRead())
+		{
+			std::cerr << "ERROR: Invalid client draw call buffer for frame " << CurrentSession->ClientFrameRequestData.FrameNumber << " skipping drawing stage.\n";
+			Win32_EndExportedFrame(viewport.FramebufferExport, CurrentSession->ClientFrameRequestData.FrameNumber, viewport.Surface);
+			continue;
+		}
+
+		// Draw calls are relative to the window. Scale them to the surface when rendering at a different resolution.
+		bool bScaled = viewport.Surface.Width != viewport.WindowWidth || viewport.Surface.Height != viewport.WindowHeight;
+		float scaleX = viewport.WindowWidth > 0 ? (float)(viewport.Surface.Width) / viewport.WindowWidth : 1.f;
+		float scaleY = viewport.WindowHeight > 0 ? (float)(viewport.Surface.Height) / viewport.WindowHeight : 1.f;
+
+		// Clip commands the client recorded get replayed in step with its draw calls.
+		Win32ClipTracker clipTracker;
+		clipTracker.Begin(viewport.ClientDrawCallBuffer, viewport.Surface, scaleX, scaleY);
+
+		DrawCall* nextDrawCall = nullptr;
+		while ((nextDrawCall = CurrentSession->Viewports[viewportID].ClientDrawCallBuffer.GetNext()) != nullptr)
+		{
+			if (bScaled)
+			{
+				Win32_ScaleDrawCall(*nextDrawCall, scaleX, scaleY);
+			}
+
+			uint32_t typeIndex = (uint32_t)(nextDrawCall->type);
+			uint64_t pixelsWritten = Win32_ProcessDrawCall(*nextDrawCall, viewport.Surface, clipTracker.GetClip(nextDrawCall));
+
+			stats.DrawCallCount++;
+			if (typeIndex < PLATFORM_RENDER_STATS_DRAW_CALL_TYPE_CAPACITY)
+			{
+				stats.DrawCallCountPerType[typeIndex]++;
+			}
+			stats.OffscreenDrawCallCount += pixelsWritten == 0;
+			stats.PixelsWritten += pixelsWritten;
+		}
+
+		// Reading stops at the first empty call, leaving the cursor past every call the client made. Clip commands take up the end of the buffer.
+		stats.DrawCallBufferBytesUsed = viewport.ClientDrawCallBuffer.CursorPosition
+			+ viewport.ClientDrawCallBuffer.ClipCommandCount * sizeof(Win32ClipCommand);
+
+		Win32_EndExportedFrame(viewport.FramebufferExport, CurrentSession->ClientFrameRequestData.FrameNumber, viewport.Surface);
+	}
+}
+
+/*
+	Hands the rendering statistics of the interactive session's viewports over to its client host if it has one, and sums them up, logging their
+	per frame averages every RENDER_STATS_LOG_INTERVAL_FRAMES frames.
+*/
+void UpdateSessionRenderStats()
+{
+	Win32ClientSession& session = Win32App.Session;
+	for (ViewportID viewportID = 0; viewportID < session.Viewports.size(); viewportID++)
+	{
+		if (!ViewportIsValid(viewportID)) continue;
+		const PlatformRenderStats& stats = session.Viewports[viewportID].RenderStats;
+
+		if (session.bClientHosted)
+		{
+			Win32_SetClientHostRenderStats(Win32App.ClientHost, (uint32_t)(viewportID), stats);
+		}
+		AccumulateRenderStats(Win32App.RenderStatsTotals, stats);
+	}
+
+	if (++Win32App.RenderStatsFrameCount >= RENDER_STATS_LOG_INTERVAL_FRAMES)
+	{
+		std::cout << "Render stats, average over the last " << Win32App.RenderStatsFrameCount << " frames: ";
+		LogRenderStats(Win32App.RenderStatsTotals, Win32App.RenderStatsFrameCount);
+
+		Win32App.RenderStatsTotals = {};
+		Win32App.RenderStatsFrameCount = 0;
+	}
+}
+
+bool GetViewportRenderStats(uint32_t ID, PlatformRenderStats& OutStats)
+{
+	// Clients running in a client host get the statistics the platform process handed over.
+	if (!Win32App.LaunchOptions.ClientHostName.empty())
+	{
+		return Win32_GetClientHostRenderStats(ID, OutStats);
+	}
+
+	if (!ViewportIsValid((ViewportID)(ID)))
+	{
+		return false;
+	}
+
+	OutStats = CurrentSession->Viewports[ID].RenderStats;
+	return true;
+}
+
+const PlatformRenderStatsAPI& Win32_GetPlatformRenderStatsAPI()
+{
+	static const PlatformRenderStatsAPI renderStatsAPI = { GetViewportRenderStats };
+	return renderStatsAPI;
+}
+
+// Returns the draw call buffer the client writes into for the passed viewport, wherever the client runs. nullptr if there is no such viewport.
+Win32DrawCallBuffer* GetClientDrawCallBuffer(uint32_t ID)
+{
+	if (!Win32App.LaunchOptions.ClientHostName.empty())
+	{
+		return Win32_GetHostedClientDrawCallBuffer(ID);
+	}
+
+	return ViewportIsValid((ViewportID)(ID)) ? &CurrentSession->Viewports[ID].ClientDrawCallBuffer : nullptr;
+}
+
+bool PushClip(uint32_t ID, int16_t X, int16_t Y, int16_t Width, int16_t Height)
+{
+	Win32DrawCallBuffer* drawCallBuffer = GetClientDrawCallBuffer(ID);
+	Win32ClipRect clipRect = { X, Y, (int32_t)(X) + max(Width, (int16_t)(0)), (int32_t)(Y) + max(Height, (int16_t)(0)) };
+	return drawCallBuffer != nullptr && drawCallBuffer->PushClip(clipRect);
+}
+
+bool PopClip(uint32_t ID)
+{
+	Win32DrawCallBuffer* drawCallBuffer = GetClientDrawCallBuffer(ID);
+	return drawCallBuffer != nullptr && drawCallBuffer->PopClip();
+}
+
+const PlatformDrawingAPI& Win32_GetPlatformDrawingAPI()
+{
+	static const PlatformDrawingAPI drawingAPI = { PushClip, PopClip };
+	return drawingAPI;
+}
+
+/*
+	Headless host state, shared by the worker threads running hosted sessions. Each worker keeps claiming the next session to run until
+	all of them ran.
+*/
+struct Win32SessionHost
+{
+	std::vector<Win32ClientSession> Sessions;
+	uint32_t FrameCount = 0;
+
+	// Index in Sessions of the next session to be claimed by a worker.
+	std::atomic<uint32_t> NextSession{ 0 };
+
+	// Time each session took to run all of its frames, in performance counter ticks. Written by the worker that ran it.
+	std::vector<int64_t> SessionRunTicks;
+
+	// Count of sessions that had to be ended before running all of their frames.
+	std::atomic<uint32_t> FailedSessionCount{ 0 };
+};
+
+/*
+	Runs the given hosted session from start to end on the calling thread: starts its client, runs every frame and rasterizes their draw calls
+	into its headless viewports, then shuts it down. Returns whether every frame could be run.
+*/
+bool RunHostedSession(Win32ClientSession& Session, uint32_t FrameCount)
+{
+	CurrentSession = &Session;
+
+	InitializeClientSession(CLIENT_PERSISTENT_MEMORY_SIZE);
+	Win32ClientAPI.StartClient(Session.ClientRunningContext);
+	Session.bClientStarted = true;
+
+	bool bAllFramesRun = true;
+	for (uint32_t frameIndex = 0; frameIndex < FrameCount; frameIndex++)
+	{
+		Session.ClientFrameRequestData = InitializeFrameRequestData(frameIndex, CLIENT_FRAME_MEMORY_SIZE);
+		if (Session.ClientFrameRequestData.FrameMemoryBuffer.Memory == nullptr)
+		{
+			std::cerr << "ERROR: Hosted session " << Session.Index << " ran out of memory at frame " << frameIndex << ", ending it early.\n";
+			bAllFramesRun = false;
+			break;
+		}
+
+		// Hosted sessions have no window and hence no cursor.
+		Session.ClientFrameRequestData.CursorLocation = {};
+		Session.ClientFrameRequestData.CursorViewport = VIEWPORT_ERROR_ID;
+
+		BeginSessionFrameDrawing();
+		Win32ClientAPI.RunClientFrame(Session.ClientRunningContext, Session.ClientFrameRequestData);
+		EndSessionFrameDrawing();
+		RasterizeSessionViewports();
+
+		FreeFrameRequestData(Session.ClientFrameRequestData);
+	}
+
+	EndClientSession();
+	CurrentSession = &Win32App.Session;
+
+	return bAllFramesRun;
+}
+
+// Entry point of the headless host's worker threads. Runs hosted sessions until none are left to claim.
+DWORD WINAPI SessionHostWorkerThreadProc(LPVOID lpParameter)
+{
+	Win32SessionHost& host = *(Win32SessionHost*)(lpParameter);
+
+	uint32_t sessionIndex;
+	while ((sessionIndex = host.NextSession.fetch_add(1, std::memory_order_relaxed)) < host.Sessions.size())
+	{
+		LARGE_INTEGER sessionStartTimestamp, sessionEndTimestamp;
+		QueryPerformanceCounter(&sessionStartTimestamp);
+
+		if (!RunHostedSession(host.Sessions[sessionIndex], host.FrameCount))
+		{
+			host.FailedSessionCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		QueryPerformanceCounter(&sessionEndTimestamp);
+		host.SessionRunTicks[sessionIndex] = sessionEndTimestamp.QuadPart - sessionStartTimestamp.QuadPart;
+	}
+
+	return 0;
+}
+
+/*
+	Runs the given count of client sessions side by side, each for the given count of frames, with as many worker threads as there are
+	logical processors. Every session is fully independent: its client gets its own persistent memory, frame memory and viewports.
+	Reports how long each session took once all of them are done. Returns whether every session ran all of its frames.
+*/
+bool RunHostedSessions(uint32_t SessionCount, uint32_t FrameCount)
+{
+	Win32SessionHost host;
+	host.Sessions.resize(SessionCount);
+	host.SessionRunTicks.resize(SessionCount, 0);
+	host.FrameCount = FrameCount;
+
+	for (uint32_t sessionIndex = 0; sessionIndex < SessionCount; sessionIndex++)
+	{
+		host.Sessions[sessionIndex].Index = sessionIndex + 1;
+	}
+
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	uint32_t workerCount = min(SessionCount, (uint32_t)(max(systemInfo.dwNumberOfProcessors, (DWORD)(1))));
+
+	std::cout << "Hosting " << SessionCount << " client sessions for " << FrameCount << " frames each, over " << workerCount << " threads.\n";
+
+	LARGE_INTEGER hostStartTimestamp, hostEndTimestamp;
+	QueryPerformanceCounter(&hostStartTimestamp);
+
+	std::vector<HANDLE> workers;
+	for (uint32_t workerIndex = 0; workerIndex < workerCount; workerIndex++)
+	{
+		HANDLE worker = CreateThread(NULL, 0, SessionHostWorkerThreadProc, &host, 0, NULL);
+		if (worker == NULL)
+		{
+			std::cerr << "ERROR: Could not create session host worker thread. Error code = " << GetLastError() << "\n";
+			continue;
+		}
+		workers.push_back(worker);
+	}
+
+	// With no worker at all, run every session on this thread instead.
+	if (workers.empty())
+	{
+		SessionHostWorkerThreadProc(&host);
+	}
+
+	for (HANDLE worker : workers)
+	{
+		WaitForSingleObject(worker, INFINITE);
+		CloseHandle(worker);
+	}
+
+	QueryPerformanceCounter(&hostEndTimestamp);
+
+	LARGE_INTEGER performanceFrequency;
+	QueryPerformanceFrequency(&performanceFrequency);
+
+	for (uint32_t sessionIndex = 0; sessionIndex < SessionCount; sessionIndex++)
+	{
+		double sessionMilliseconds = (double)(host.SessionRunTicks[sessionIndex]) * 1000.0 / performanceFrequency.QuadPart;
+		std::cout << "Session " << host.Sessions[sessionIndex].Index << ": " << sessionMilliseconds << " ms ("
+			<< sessionMilliseconds / FrameCount << " ms per frame)\n";
+	}
+
+	double hostMilliseconds = (double)(hostEndTimestamp.QuadPart - hostStartTimestamp.QuadPart) * 1000.0 / performanceFrequency.QuadPart;
+	std::cout << "Hosted " << SessionCount << " sessions in " << hostMilliseconds << " ms, "
+		<< (double)(SessionCount) * FrameCount * 1000.0 / max(hostMilliseconds, 1.0) << " session frames per second.\n";
+
+	uint32_t failedSessionCount = host.FailedSessionCount.load();
+	if (failedSessionCount > 0)
+	{
+		std::cerr << "ERROR: " << failedSessionCount << " hosted sessions ended before running all of their frames.\n";
+	}
+
+	return failedSessionCount == 0;
+}
+
+/*
+	Final program cleanup code ran when the program ends for ANY reason.
+	When Force Shutdown is true, a lot of "heavy" or thread-sensitive cleanup operations will be skipped, the priority being to free
+	external resources, cleanup temporary files and exit before the OS timeout forces us to.
+*/
+void OnProgramEnd()
+{
+	Win32_StopTempDataFolderCleanup();
+
+	// Pending file requests may write into client memory, so they must be done with before the session frees it.
+	Win32_StopFileIO();
+
+	// End the interactive session, shutting its client down, then unload the client library.
+	EndClientSession();
+
+	// If Client API was ever successfully loaded, unload it.
+	if (Win32ClientAPI.APISuccessfullyLoaded())
+	{
+		Win32_UnloadClientModule(Win32ClientAPI);
+	}
+
+	// The client is gone along with any pointer it had into assets and allocators.
+	Win32_UnmountAssetPack();
+	Win32_FreeAllocators();
+
+	Win32_FreePixelSurfacePool();
+
+	StopInputThread();
+
+	Win32_EndInputRecording();
+	Win32_EndInputReplay();
+	Win32_EndDrawCallCapture();
+	Win32_EndFrameCapture();
+
+#if HOTRELOAD_SUPPORTED
+	Win32_StopHotreloadWatcher();
+	Win32_CleanupHotreloadFiles();
+#endif
+
+	if (DEBUG_CONSOLE)
+	{
+		system("pause");
+		CloseConsole();
+	}
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance,
+	_In_opt_ HINSTANCE hPrevInstance,
+	_In_ LPSTR lpCmdLine,
+	_In_ int nShowCmd)
+{
+	Win32App.ProgramInstance = hInstance;
+
+	// Client host processes get launched with the client host option first (see LaunchClientHostProcess()), and share the platform's console.
+	bool bClientHostProcess = strncmp(lpCmdLine, "-client-host ", strlen("-client-host ")) == 0;
+
+	if (DEBUG_CONSOLE)
+	{
+		CreateConsole(bClientHostProcess);
+	}
+
+	Win32App.LaunchOptions = ParseLaunchOptions(lpCmdLine);
+
+	// Client host processes only run the client on behalf of the platform process that launched them, leaving everything else to it.
+	if (bClientHostProcess && !Win32App.LaunchOptions.ClientHostName.empty())
+	{
+		// File requests get served and assets mounted by the process the client runs in.
+		Win32_StartFileIO();
+		MountAssetPack();
+		LoadClientModule();
+		int clientHostExitCode = Win32_RunClientHost(Win32App.LaunchOptions.ClientHostName, Win32ClientAPI);
+		Win32_StopFileIO();
+
+		if (Win32ClientAPI.APISuccessfullyLoaded())
+		{
+			Win32_UnloadClientModule(Win32ClientAPI);
+		}
+#if HOTRELOAD_SUPPORTED
+		Win32_CleanupHotreloadFiles();
+#endif
+		Win32_UnmountAssetPack();
+		Win32_FreeAllocators();
+
+		if (DEBUG_CONSOLE)
+		{
+			CloseConsole();
+		}
+		return clientHostExitCode;
+	}
+
+	// Reset Temp folder which serves as a staging area for all files that are only relevant while the program runs.
+	Win32_ResetTempDataFolder();
 
-	// Input buffers
-	Win32ActionInputBuffer inputBuffers[2];
-	inputBuffers[0].Buffer = (ActionInputEvent*)(malloc(sizeof(ActionInputEvent) * 64));
-	memset(inputBuffers[0].Buffer, 0, sizeof(ActionInputEvent) * 64);
-	inputBuffers[0].EventCount = 0;
-	inputBuffers[0].MaxEventCount = 64;
+	// Draw call trace replays run the rasterizer alone, without any client, window or input.
+	if (!Win32App.LaunchOptions.DrawCallReplayPath.empty())
+	{
+		bool bReplaySuccessful = Win32_ReplayDrawCallTrace(Win32App.LaunchOptions.DrawCallReplayPath);
+		OnProgramEnd();
+		return bReplaySuccessful ? 0 : 1;
+	}
+
+	// Start Input thread, which will own viewport windows. Needs to be up before the client can allocate any viewport.
+	// Headless sessions have no windows and therefore no live input.
+	if (!Win32App.LaunchOptions.bHeadless && !StartInputThread())
+	{
+		std::cerr << "FATAL ERROR: Platform initialization failed ! Ending program.\n";
+		OnProgramEnd();
+		return 1;
+	}
+
+	// Input Replay & Recording
+	if (!Win32App.LaunchOptions.InputReplayPath.empty() && !Win32_BeginInputReplay(Win32App.LaunchOptions.InputReplayPath))
+	{
+		std::cerr << "FATAL ERROR: Failed to start requested input replay ! Ending program.\n";
+		OnProgramEnd();
+		return 1;
+	}
+
+	if (!Win32App.LaunchOptions.InputRecordingPath.empty())
+	{
+		Win32_BeginInputRecording(Win32App.LaunchOptions.InputRecordingPath);
+	}
+
+	// Draw Call Capture
+	if (!Win32App.LaunchOptions.DrawCallCapturePath.empty())
+	{
+		Win32_BeginDrawCallCapture(Win32App.LaunchOptions.DrawCallCapturePath);
+	}
+
+	// Frame Capture
+	if (!Win32App.LaunchOptions.FrameCapturePath.empty())
+	{
+		Win32_BeginFrameCapture(Win32App.LaunchOptions.FrameCapturePath);
+	}
+
+	// Isolated clients get loaded by the client host process instead. File services must be up before loading, as the client gets them on load.
+	if (!Win32App.LaunchOptions.bIsolateClient)
+	{
+		if (!Win32_StartFileIO())
+		{
+			std::cerr << "WARNING: File services are unavailable. Client file requests will fail.\n";
+		}
+		MountAssetPack();
+		LoadClientModule();
+	}
+
+	if (!Win32App.LaunchOptions.bIsolateClient && !AppContextInitSuccessful())
+	{
+		std::cerr << "FATAL ERROR: Platform initialization failed ! Ending program.\n";
+		OnProgramEnd();
+		return 1;
+	}
+
+	// Headless hosts run their own sessions in parallel, then end the program.
+	if (Win32App.LaunchOptions.HostedSessionCount > 0)
+	{
+		bool bHostSuccessful = RunHostedSessions(Win32App.LaunchOptions.HostedSessionCount, Win32App.LaunchOptions.HostedFrameCount);
+		OnProgramEnd();
+		return bHostSuccessful ? 0 : 1;
+	}
+
+	// Launch the client host first when isolating the client, as client memory lives in its shared memory.
+	if (Win32App.LaunchOptions.bIsolateClient)
+	{
+		// The client host mounts the asset pack itself.
+		std::string clientHostArguments = Win32App.LaunchOptions.bAssetPackPathGiven ? "-asset-pack \"" + Win32App.LaunchOptions.AssetPackPath + "\"" : "";
+		if (!Win32_StartClientHost(Win32App.ClientHost, CLIENT_PERSISTENT_MEMORY_SIZE, CLIENT_FRAME_MEMORY_SIZE, clientHostArguments))
+		{
+			std::cerr << "FATAL ERROR: Could not launch client host process ! Ending program.\n";
+			OnProgramEnd();
+			return 1;
+		}
+		Win32App.Session.bClientHosted = true;
+	}
+
+	// Initialize Client Context & Run Client Start, if the app initialized successfully.
+	InitializeClientSession(CLIENT_PERSISTENT_MEMORY_SIZE);
 
-	inputBuffers[1].Buffer = (ActionInputEvent*)(malloc(sizeof(ActionInputEvent) * 64));
-	memset(inputBuffers[1].Buffer, 0, sizeof(ActionInputEvent) * 64);
-	inputBuffers[1].EventCount = 0;
-	inputBuffers[1].MaxEventCount = 64;
+	// Start the client
+	if (!StartSessionClient())
+	{
+		std::cerr << "FATAL ERROR: Client failed to start ! Ending program.\n";
+		OnProgramEnd();
+		return 1;
+	}
 
-	// Set first backbuffer to index 0. It will be the first to be filled in with input events and used for the first client frame.
-	Win32App.InputBackbuffer = &inputBuffers[0];
-	Win32App.InputFrontbuffer = &inputBuffers[1];
+#if HOTRELOAD_SUPPORTED
+	// Watch for new client library versions from now on. Client hosts watch for them on their own.
+	if (!Win32App.Session.bClientHosted)
+	{
+		Win32_StartHotreloadWatcher();
+	}
+#endif
 
 	// Frame & Time tracking
 	size_t frameCounter = 0;
 
+	LARGE_INTEGER frameStartTimestamp;
+	QueryPerformanceCounter(&frameStartTimestamp);
+	Win32App.LastFrameStartTimestamp = frameStartTimestamp.QuadPart;
+
+	LARGE_INTEGER runStartTimestamp = frameStartTimestamp;
+
 	// Let the party begin
 	Win32App.bRunning = true;
 	while (Win32App.bRunning)
 	{
 #if HOTRELOAD_SUPPORTED
-		Win32_TryHotreloadClientModule(Win32ClientAPI);
+		Win32_UpdateHotreloadCompile(Win32ClientAPI, !Win32App.Session.bClientHosted);
+		Win32_HotreloadClientModuleIfReady(Win32ClientAPI);
 #endif
 
-		for (ViewportID viewportID = 0; viewportID < Win32App.Viewports.size(); viewportID++)
+		// Process input records received by the Input thread since the last frame.
+		QueryPerformanceCounter(&frameStartTimestamp);
+		ProcessInputRecords(frameStartTimestamp.QuadPart);
+
+		// Prepare frame data for next client frame.
+		CurrentSession->ClientFrameRequestData = InitializeFrameRequestData(frameCounter, CLIENT_FRAME_MEMORY_SIZE);
+
+		// When replaying, recorded input replaces live input and the run ends with the recording.
+		if (Win32_IsReplayingInput() && !Win32_ReplayFrameInput(CurrentSession->ClientFrameRequestData))
 		{
-			if (!ViewportIsValid(viewportID)) continue;
-			
-			// Message processing & Drawing loop.
-			MSG message;
-			while (PeekMessage(&message, Win32App.Viewports[viewportID].Win32WindowHandle, NULL, NULL, PM_REMOVE))
-			{
-				TranslateMessage(&message);
-				DispatchMessage(&message);
-			}
+			FreeFrameRequestData(CurrentSession->ClientFrameRequestData);
+			break;
 		}
 
-		// Switch input buffers so backbuffer that was just filled in with messages will become front buffer and be used by the frame.
-		Win32ActionInputBuffer* swapTemp = Win32App.InputBackbuffer;
-		Win32App.InputBackbuffer = Win32App.InputFrontbuffer;
-		Win32App.InputFrontbuffer = swapTemp;
-
-		// Reset new backbuffer and assign it to application context.
-		Win32App.InputBackbuffer->EventCount = 0;
-		memset(Win32App.InputBackbuffer->Buffer, 0, Win32App.InputBackbuffer->MaxEventCount * sizeof(ActionInputEvent));
-		
-		// Prepare frame data for next client frame.
-		Win32App.ClientFrameRequestData = InitializeFrameRequestData(frameCounter, 1024 * 16); // 16kB frame memory
+		Win32_RecordFrameInput(CurrentSession->ClientFrameRequestData);
 
-		// Put the draw buffers in write mode.
-		for (ViewportID viewportID = 0; viewportID < Win32App.Viewports.size(); viewportID++)
+		// Put the draw buffers in write mode, then run Client Frame.
+		BeginSessionFrameDrawing();
+		if (!RunSessionClientFrame())
 		{
-			if (!ViewportIsValid(viewportID)) continue;
-			if (!Win32App.Viewports[viewportID].ClientDrawCallBuffer.BeginWrite())
+			// The client host crashed or hung. Bring a new one up, drawing nothing this frame.
+			if (!RestartSessionClientHost())
 			{
-				// If the buffer can't be written into for any reason, unlink Draw Call function.
-				// This will effectively disable drawing for this frame.
-				std::cerr << "ERROR: Could not set draw buffer to write mode for frame " << Win32App.ClientFrameRequestData.FrameNumber << "\n";
-				Win32App.ClientFrameRequestData.NewDrawCall = nullptr;
+				std::cerr << "FATAL ERROR: Could not restart the client host ! Ending program.\n";
+				FreeFrameRequestData(CurrentSession->ClientFrameRequestData);
+				break;
 			}
+			BeginSessionFrameDrawing();
 		}
+		EndSessionFrameDrawing();
+
+		// Capture draw calls as the client emitted them, before rasterization modifies them.
+		for (ViewportID viewportID = 0; viewportID < CurrentSession->Viewports.size(); viewportID++)
+		{
+			if (!ViewportIsValid(viewportID)) continue;
+			Win32Viewport& viewport = CurrentSession->Viewports[viewportID];
 
-		// Run Client Frame
-		Win32ClientAPI.RunClientFrame(Win32App.ClientRunningContext, Win32App.ClientFrameRequestData);
+			Win32_CaptureDrawCalls(CurrentSession->ClientFrameRequestData.FrameNumber, (uint32_t)(viewport.ID), viewport.WindowWidth, viewport.WindowHeight,
+				viewport.ClientDrawCallBuffer);
+		}
 
 		// Drawing pass - rasterize all incoming draw calls after clearing the screen to black.
+		RasterizeSessionViewports();
+		UpdateSessionRenderStats();
 
-		// Read draw calls and process them.
-		for (ViewportID viewportID = 0; viewportID < Win32App.Viewports.size(); viewportID++)
+		// Blit updated pixels onto each Viewport's window.
+		for (ViewportID viewportID = 0; viewportID < CurrentSession->Viewports.size(); viewportID++)
 		{
 			if (!ViewportIsValid(viewportID)) continue;
-			Win32Viewport& viewport = Win32App.Viewports[viewportID];
-			
-			// Clear screen to blue.
-			Win32_ClearPixelBuffer(0xFF000000, viewport.PixelBuffer, viewport.PixelBufferWidth, viewport.PixelBufferHeight);
+			Win32Viewport& viewport = CurrentSession->Viewports[viewportID];
+			if (viewport.Win32WindowHandle == NULL || !ViewportIsVisible(viewport)) continue;
 			
-			if (!viewport.ClientDrawCallBuffer.BeginRead())
+			if (viewport.Surface.Width == viewport.WindowWidth && viewport.Surface.Height == viewport.WindowHeight)
 			{
-				std::cerr << "ERROR: Invalid client draw call buffer for frame " << Win32App.ClientFrameRequestData.FrameNumber << " skipping drawing stage.\n";
-				continue;
+				BitBlt(viewport.Win32WindowDC, 0, 0, viewport.Surface.Width, viewport.Surface.Height, viewport.Surface.BitmapDC, 0, 0, SRCCOPY);
 			}
-
-			DrawCall* nextDrawCall = nullptr;
-			while ((nextDrawCall = Win32App.Viewports[viewportID].ClientDrawCallBuffer.GetNext()) != nullptr)
+			else
 			{
-				Win32_ProcessDrawCall(*nextDrawCall, viewport.PixelBuffer, viewport.PixelBufferWidth, viewport.PixelBufferHeight);
+				StretchBlt(viewport.Win32WindowDC, 0, 0, viewport.WindowWidth, viewport.WindowHeight, 
+					viewport.Surface.BitmapDC, 0, 0, viewport.Surface.Width, viewport.Surface.Height, SRCCOPY);
 			}
 		}
 
-		// Blit updated pixels onto each Viewport's window.
-		for (ViewportID viewportID = 0; viewportID < Win32App.Viewports.size(); viewportID++)
+		// Capture rendered frames, headless ones included. Only copies pixels here, encoding and writing happen on the capture writer thread.
+		for (ViewportID viewportID = 0; viewportID < CurrentSession->Viewports.size(); viewportID++)
 		{
 			if (!ViewportIsValid(viewportID)) continue;
-			Win32Viewport& viewport = Win32App.Viewports[viewportID];
-			
-			BitBlt(viewport.Win32WindowDC, 0, 0, viewport.PixelBufferWidth, viewport.PixelBufferHeight, viewport.DrawingBitmapDC, 0, 0, SRCCOPY);
+			Win32Viewport& viewport = CurrentSession->Viewports[viewportID];
+			if (!ViewportIsVisible(viewport)) continue;
+
+			Win32_CaptureFrame(CurrentSession->ClientFrameRequestData.FrameNumber, (uint32_t)(viewport.ID), viewport.Surface);
 		}
 
 		// Free resources taken by Client frame.
-		FreeFrameRequestData(Win32App.ClientFrameRequestData);
+		FreeFrameRequestData(CurrentSession->ClientFrameRequestData);
+
+		// Reset the input buffer for the next frame. Only the range used by this frame's events needs zeroing out.
+		memset(CurrentSession->InputBuffer.Buffer, 0, CurrentSession->InputBuffer.EventCount * sizeof(ActionInputEvent));
+		CurrentSession->InputBuffer.EventCount = 0;
+
+		frameCounter++;
+
+		// Throttle frames while every viewport window is minimized or hidden. The client keeps running, only less often.
+		bool bAnyWindowVisible = false;
+		bool bAnyWindow = false;
+		for (ViewportID viewportID = 0; viewportID < CurrentSession->Viewports.size(); viewportID++)
+		{
+			if (!ViewportIsValid(viewportID) || CurrentSession->Viewports[viewportID].Win32WindowHandle == NULL) continue;
+
+			bAnyWindow = true;
+			bAnyWindowVisible |= ViewportIsVisible(CurrentSession->Viewports[viewportID]);
+		}
+
+		// Replays feed recorded input every frame so they never wait.
+		if (!Win32_IsReplayingInput())
+		{
+			// Let an idle client skip frames until input comes in or it asks to run again.
+			uint32_t idleWaitMilliseconds = CurrentSession->bClientHosted ? Win32_GetClientHostIdleWaitMilliseconds(Win32App.ClientHost)
+				: Win32_GetClientIdleWaitMilliseconds(CurrentSession->ClientRunningContext);
+			if (idleWaitMilliseconds > 0)
+			{
+				WaitForInput(min(idleWaitMilliseconds, (uint32_t)(CLIENT_IDLE_WAIT_MAX_MS)));
+			}
+			else if (bAnyWindow && !bAnyWindowVisible)
+			{
+				Sleep(HIDDEN_VIEWPORTS_FRAME_SLEEP_MS);
+			}
+		}
+	}
+
+	if (Win32_IsReplayingInput())
+	{
+		// Report replay timings for build comparisons.
+		LARGE_INTEGER runEndTimestamp, performanceFrequency;
+		QueryPerformanceCounter(&runEndTimestamp);
+		QueryPerformanceFrequency(&performanceFrequency);
+
+		double runMilliseconds = (runEndTimestamp.QuadPart - runStartTimestamp.QuadPart) * 1000.0 / performanceFrequency.QuadPart;
+		std::cout << "Input replay done: " << frameCounter << " frames in " << runMilliseconds << " ms ("
+			<< (frameCounter > 0 ? runMilliseconds / frameCounter : 0.0) << " ms per frame).\n";
 	}
 
 	OnProgramEnd();